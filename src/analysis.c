@@ -0,0 +1,141 @@
+#include "analysis.h"
+
+#include <string.h>
+
+#define SNAPSHOT_FRESH 4u
+
+static void publishSnapshot(struct Analysis *analysis) {
+  unsigned previous = atomic_exchange_explicit(
+      &analysis->middle, analysis->back | SNAPSHOT_FRESH, memory_order_acq_rel);
+  analysis->back = previous & 3u;
+}
+
+// Deepens one ply at a time until cancelled, running every line at each
+// depth with the moves of the better lines excluded, so no depth is searched
+// twice. Every finished depth is published, so the UI sees results improve
+// while the search goes on; only the search's depth ceiling ends it early.
+static void *analysisThread(void *arg) {
+  struct Analysis *analysis = (struct Analysis *)arg;
+  struct Search *search = analysis->search;
+  long long nodes = 0;
+
+  for (int depth = 1; depth <= SEARCH_MAX_DEPTH; depth++) {
+    struct AnalysisSnapshot *snapshot = &analysis->slots[analysis->back];
+    snapshot->positionHash = GetPositionHash(analysis->game);
+    snapshot->sideToMove = GetCurrentPlayer(analysis->game);
+    snapshot->depth = depth;
+    snapshot->lineCount = 0;
+    search->excludedCount = 0;
+
+    for (unsigned k = 0; k < analysis->lineCount; k++) {
+      struct SearchResult result = SearchDepth(search, depth);
+      nodes += result.nodes;
+
+      if (atomic_load(&analysis->cancel))
+        return NULL;
+      if (IS_NULL_MOVE(result.bestMove))
+        break;
+
+      struct AnalysisLine *line = &snapshot->lines[snapshot->lineCount++];
+      line->score = result.score;
+      line->depth = result.depth;
+      line->pvLength = result.pvLength < ANALYSIS_PV_LENGTH
+                           ? result.pvLength
+                           : ANALYSIS_PV_LENGTH;
+      memcpy(line->pv, result.pv, line->pvLength * sizeof(struct Move));
+      search->excluded[search->excludedCount++] = result.bestMove;
+    }
+
+    snapshot->nodes = nodes;
+    publishSnapshot(analysis);
+    TraceLog(LOG_DEBUG, "Analysis published depth %d", depth);
+
+    if (snapshot->lineCount == 0)
+      break;
+  }
+  return NULL;
+}
+
+struct Analysis *NewAnalysis(unsigned lineCount) {
+  struct Analysis *analysis =
+      (struct Analysis *)calloc(1, sizeof(struct Analysis));
+  if (analysis == NULL) {
+    TraceLog(LOG_ERROR, "Failed to allocate memory for analysis");
+    return NULL;
+  }
+
+  analysis->game = NewGame();
+  analysis->search = (struct Search *)malloc(sizeof(struct Search));
+  if (analysis->game == NULL || analysis->search == NULL ||
+      !NewTranspositionTable(&analysis->tt, ANALYSIS_TT_SIZE_MB)) {
+    TraceLog(LOG_ERROR, "Failed to allocate analysis search state");
+    DeleteGame(analysis->game);
+    free(analysis->search);
+    free(analysis);
+    return NULL;
+  }
+
+  InitSearch(analysis->search, analysis->game, &analysis->tt);
+  analysis->search->cancel = &analysis->cancel;
+  analysis->lineCount = lineCount;
+  if (analysis->lineCount < 1)
+    analysis->lineCount = 1;
+  if (analysis->lineCount > ANALYSIS_MAX_LINES)
+    analysis->lineCount = ANALYSIS_MAX_LINES;
+  atomic_init(&analysis->cancel, false);
+  analysis->back = 0;
+  atomic_init(&analysis->middle, 1u);
+  analysis->front = 2;
+  return analysis;
+}
+
+void StopAnalysis(struct Analysis *analysis) {
+  if (analysis == NULL || !analysis->running)
+    return;
+
+  atomic_store(&analysis->cancel, true);
+  pthread_join(analysis->thread, NULL);
+  analysis->running = false;
+  TraceLog(LOG_DEBUG, "Analysis stopped");
+}
+
+// (Re)starts analysis of `game`. The transposition table and ordering
+// heuristics are kept, so the new position profits from the old search.
+void StartAnalysis(struct Analysis *analysis, const struct Game *game) {
+  if (analysis == NULL)
+    return;
+
+  StopAnalysis(analysis);
+  CopyGame(analysis->game, game);
+  atomic_store(&analysis->cancel, false);
+
+  if (pthread_create(&analysis->thread, NULL, analysisThread, analysis) != 0) {
+    TraceLog(LOG_ERROR, "Failed to start analysis thread");
+    return;
+  }
+  analysis->running = true;
+  TraceLog(LOG_DEBUG, "Analysis started");
+}
+
+// Returns the newest published snapshot. Only one thread may read; the
+// pointer stays valid until its next call.
+const struct AnalysisSnapshot *GetAnalysisSnapshot(struct Analysis *analysis) {
+  if (atomic_load_explicit(&analysis->middle, memory_order_acquire) &
+      SNAPSHOT_FRESH) {
+    unsigned previous = atomic_exchange_explicit(
+        &analysis->middle, analysis->front, memory_order_acq_rel);
+    analysis->front = previous & 3u;
+  }
+  return &analysis->slots[analysis->front];
+}
+
+void DeleteAnalysis(struct Analysis *analysis) {
+  if (analysis == NULL)
+    return;
+
+  StopAnalysis(analysis);
+  DeleteTranspositionTable(&analysis->tt);
+  free(analysis->search);
+  DeleteGame(analysis->game);
+  free(analysis);
+}
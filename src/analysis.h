@@ -0,0 +1,57 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "game.h"
+#include "search.h"
+
+#define ANALYSIS_MAX_LINES 4
+#define ANALYSIS_PV_LENGTH 12
+#define ANALYSIS_TT_SIZE_MB 64
+
+struct AnalysisLine {
+  struct Move pv[ANALYSIS_PV_LENGTH];
+  int pvLength;
+  // Centipawns from the point of view of the side to move
+  int score;
+  int depth;
+};
+
+struct AnalysisSnapshot {
+  uint64_t positionHash;
+  enum Player sideToMove;
+  int depth;
+  long long nodes;
+  unsigned lineCount;
+  struct AnalysisLine lines[ANALYSIS_MAX_LINES];
+};
+
+// Background multi-PV search of a private copy of the game. Results are
+// published through a triple buffer: the search thread fills `back`, swaps
+// it into `middle`, and the reader swaps `middle` into `front`, so neither
+// side ever waits on the other.
+struct Analysis {
+  struct Game *game;
+  struct Search *search;
+  struct TranspositionTable tt;
+  unsigned lineCount;
+
+  pthread_t thread;
+  bool running;
+  atomic_bool cancel;
+
+  struct AnalysisSnapshot slots[3];
+  unsigned back;
+  unsigned front;
+  atomic_uint middle;
+};
+
+struct Analysis *NewAnalysis(unsigned lineCount);
+void DeleteAnalysis(struct Analysis *analysis);
+void StartAnalysis(struct Analysis *analysis, const struct Game *game);
+void StopAnalysis(struct Analysis *analysis);
+const struct AnalysisSnapshot *GetAnalysisSnapshot(struct Analysis *analysis);
+
+#endif // ANALYSIS_H
@@ -0,0 +1,349 @@
+// Headless micro-benchmarks for the game logic and search.
+//
+// Usage: ./bench [--samples N] [--cpu N] [--output file]
+//                [--baseline file] [--threshold fraction]
+//
+// Results are written as JSON, one benchmark per line, along with the speed
+// of full depth-5 searches in nodes per second. With --baseline the medians
+// and the search speed are compared against a previous run from the same
+// machine, and the exit status is 1 when any of them regressed by more than
+// the threshold (default 0.10).
+
+#define _GNU_SOURCE
+#include <sched.h>
+#include <string.h>
+
+#include "positions.h"
+#include "search.h"
+#include "tools.h"
+
+#define MAX_BENCHMARKS 32
+#define MAX_TARGETS 1024
+#define WARMUP_NS 100000000LL
+#define SAMPLE_NS 1000000LL
+#define SEARCH_DEPTH 3
+#define SPEED_DEPTH 5
+
+struct BenchContext {
+  struct Game *games[16];
+  unsigned gameCount;
+  // Start position used by the benchmarks that mutate the game
+  struct Game *scratch;
+  // Squares holding the piece type under test, paired with their game
+  struct Game *targetGames[MAX_TARGETS];
+  Vector2 targets[MAX_TARGETS];
+  unsigned targetCount;
+  unsigned next;
+  struct Search *search;
+  struct TranspositionTable tt;
+};
+
+// Each run performs some work and returns how many units it covered, so
+// per-unit cost is elapsed time divided by the returned count
+typedef long long (*BenchRun)(struct BenchContext *ctx);
+
+struct BenchResult {
+  const char *name;
+  const char *unit;
+  double median;
+  double p99;
+  unsigned samples;
+};
+
+static volatile unsigned sink;
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static long long runGetPossibleMoves(struct BenchContext *ctx) {
+  unsigned i = ctx->next++ % ctx->targetCount;
+  struct Moves moves = GetPossibleMoves(ctx->targetGames[i], &ctx->targets[i]);
+  sink += moves.size;
+  return 1;
+}
+
+// A four-ply knight shuffle that returns to the start position
+static long long runMovePiece(struct BenchContext *ctx) {
+  static const Vector2 shuffle[4][2] = {
+      {{6, 7}, {5, 5}},
+      {{6, 0}, {5, 2}},
+      {{5, 5}, {6, 7}},
+      {{5, 2}, {6, 0}},
+  };
+  struct Game *game = ctx->scratch;
+  for (int i = 0; i < 4; i++) {
+    sink += MovePiece(game, &shuffle[i][0], &shuffle[i][1]);
+    NextPlayer(game);
+  }
+  return 4;
+}
+
+static long long runNewDeleteGame(struct BenchContext *ctx) {
+  (void)ctx;
+  struct Game *game = NewGame();
+  sink += game != NULL;
+  DeleteGame(game);
+  return 1;
+}
+
+static long long runResetDefaultConfiguration(struct BenchContext *ctx) {
+  ResetDefaultConfiguration(ctx->scratch);
+  return 1;
+}
+
+static long long runSearch(struct BenchContext *ctx) {
+  unsigned i = ctx->next++ % ctx->gameCount;
+  struct Search *search = ctx->search;
+
+  search->game = ctx->games[i];
+  ClearTranspositionTable(search->tt);
+  ClearSearchHeuristics(&search->heuristics);
+
+  struct SearchLimits limits = {.depth = SEARCH_DEPTH};
+  struct SearchResult result = SearchPosition(search, &limits);
+  return result.nodes > 0 ? result.nodes : 1;
+}
+
+// Whole searches to SPEED_DEPTH, one per position, so the speed reflects
+// deeper trees than the per-node benchmark above
+static double measureSearchSpeed(struct BenchContext *ctx) {
+  struct Search *search = ctx->search;
+  long long nodes = 0;
+
+  long long start = GetMonotonicTimeNs();
+  for (unsigned i = 0; i < ctx->gameCount; i++) {
+    search->game = ctx->games[i];
+    ClearTranspositionTable(search->tt);
+    ClearSearchHeuristics(&search->heuristics);
+
+    struct SearchLimits limits = {.depth = SPEED_DEPTH};
+    nodes += SearchPosition(search, &limits).nodes;
+  }
+  return nodes * 1e9 / (double)(GetMonotonicTimeNs() - start);
+}
+
+static struct BenchResult measure(const char *name, const char *unit,
+                                  BenchRun run, struct BenchContext *ctx,
+                                  unsigned samples) {
+  // Warm up caches and branch predictors, and size the inner loop so one
+  // sample takes roughly SAMPLE_NS
+  long long runs = 0;
+  long long start = GetMonotonicTimeNs();
+  while (GetMonotonicTimeNs() - start < WARMUP_NS || runs == 0) {
+    run(ctx);
+    runs++;
+  }
+  long long perSample = runs * SAMPLE_NS / WARMUP_NS;
+  if (perSample < 1)
+    perSample = 1;
+
+  double *costs = (double *)malloc(samples * sizeof(double));
+  for (unsigned s = 0; s < samples; s++) {
+    long long units = 0;
+    long long begin = GetMonotonicTimeNs();
+    for (long long r = 0; r < perSample; r++)
+      units += run(ctx);
+    costs[s] = (double)(GetMonotonicTimeNs() - begin) / (double)units;
+  }
+
+  qsort(costs, samples, sizeof(double), compareDoubles);
+  unsigned p99 = (unsigned)(samples * 0.99);
+  struct BenchResult result = {
+      .name = name,
+      .unit = unit,
+      .median = costs[samples / 2],
+      .p99 = costs[p99 < samples ? p99 : samples - 1],
+      .samples = samples,
+  };
+  free(costs);
+  return result;
+}
+
+static void collectTargets(struct BenchContext *ctx, enum PieceType type) {
+  ctx->targetCount = 0;
+  ctx->next = 0;
+  for (unsigned g = 0; g < ctx->gameCount; g++) {
+    for (int x = 0; x < 8; x++) {
+      for (int y = 0; y < 8; y++) {
+        struct Piece *p = GetPieceInXYPosition(ctx->games[g], x, y);
+        if (p != NULL && p->type == type && ctx->targetCount < MAX_TARGETS) {
+          ctx->targetGames[ctx->targetCount] = ctx->games[g];
+          ctx->targets[ctx->targetCount++] = p->square;
+        }
+      }
+    }
+  }
+}
+
+static void writeResults(FILE *out, const struct BenchResult *results,
+                         unsigned count, double nodesPerSecond) {
+  fprintf(out, "{\n  \"searchNodesPerSecond\": %.0f,\n", nodesPerSecond);
+  fprintf(out, "  \"benchmarks\": [\n");
+  for (unsigned i = 0; i < count; i++) {
+    fprintf(out,
+            "    {\"name\": \"%s\", \"unit\": \"%s\", \"median\": %.2f, "
+            "\"p99\": %.2f, \"samples\": %u}%s\n",
+            results[i].name, results[i].unit, results[i].median,
+            results[i].p99, results[i].samples, i + 1 < count ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+// Reads a file written by writeResults and reports every benchmark whose
+// median grew, or a search speed that fell, by more than `threshold`.
+// Returns the number of regressions.
+static int compareWithBaseline(const char *path,
+                               const struct BenchResult *results,
+                               unsigned count, double nodesPerSecond,
+                               double threshold) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open baseline '%s'\n", path);
+    return -1;
+  }
+
+  int regressions = 0;
+  char line[512];
+  while (fgets(line, sizeof(line), file)) {
+    char name[128];
+    double median;
+    double baselineSpeed;
+    if (sscanf(line, " \"searchNodesPerSecond\": %lf", &baselineSpeed) == 1) {
+      double change = (nodesPerSecond - baselineSpeed) / baselineSpeed;
+      bool regressed = -change > threshold;
+      fprintf(stderr, "%-36s %10.0f -> %10.0f %+7.1f%%%s\n", "search nodes/sec",
+              baselineSpeed, nodesPerSecond, change * 100.0,
+              regressed ? "  REGRESSION" : "");
+      regressions += regressed;
+      continue;
+    }
+
+    if (sscanf(line, " {\"name\": \"%127[^\"]\", \"unit\": \"%*[^\"]\", "
+                     "\"median\": %lf",
+               name, &median) != 2)
+      continue;
+
+    for (unsigned i = 0; i < count; i++) {
+      if (strcmp(results[i].name, name) != 0)
+        continue;
+
+      double change = (results[i].median - median) / median;
+      bool regressed = change > threshold;
+      fprintf(stderr, "%-36s %10.2f -> %10.2f %+7.1f%%%s\n", name, median,
+              results[i].median, change * 100.0,
+              regressed ? "  REGRESSION" : "");
+      regressions += regressed;
+    }
+  }
+
+  fclose(file);
+  return regressions;
+}
+
+int main(int argc, char **argv) {
+  static const char *const movegenNames[6] = {
+      [Pawn] = "GetPossibleMoves/Pawn",
+      [Knight] = "GetPossibleMoves/Knight",
+      [Bishop] = "GetPossibleMoves/Bishop",
+      [King] = "GetPossibleMoves/King",
+      [Rook] = "GetPossibleMoves/Rook",
+      [Queen] = "GetPossibleMoves/Queen",
+  };
+  unsigned samples = 200;
+  int cpu = 0;
+  const char *outputPath = NULL;
+  const char *baselinePath = NULL;
+  double threshold = 0.10;
+
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 == argc) {
+      fprintf(stderr, "Option '%s' needs a value\n", argv[i]);
+      return 1;
+    }
+    if (strcmp(argv[i], "--samples") == 0)
+      samples = (unsigned)atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--cpu") == 0)
+      cpu = atoi(argv[i + 1]);
+    else if (strcmp(argv[i], "--output") == 0)
+      outputPath = argv[i + 1];
+    else if (strcmp(argv[i], "--baseline") == 0)
+      baselinePath = argv[i + 1];
+    else if (strcmp(argv[i], "--threshold") == 0)
+      threshold = atof(argv[i + 1]);
+    else {
+      fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+      return 1;
+    }
+  }
+  if (samples == 0)
+    samples = 1;
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  // Pin to one core so migrations do not show up as noise
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (sched_setaffinity(0, sizeof(set), &set) != 0)
+    fprintf(stderr, "Could not pin to CPU %d, results may be noisy\n", cpu);
+
+  static struct BenchContext ctx;
+  for (unsigned i = 0; i < BenchmarkPositionCount && i < 16; i++) {
+    ctx.games[i] = NewGame();
+    if (ctx.games[i] == NULL || !LoadFEN(ctx.games[i], BenchmarkPositions[i]))
+      return 1;
+    ctx.gameCount++;
+  }
+  ctx.scratch = NewGame();
+  ctx.search = (struct Search *)malloc(sizeof(struct Search));
+  if (ctx.scratch == NULL || ctx.search == NULL ||
+      !NewTranspositionTable(&ctx.tt, 16))
+    return 1;
+  InitSearch(ctx.search, ctx.games[0], &ctx.tt);
+
+  struct BenchResult results[MAX_BENCHMARKS];
+  unsigned count = 0;
+
+  for (int type = Pawn; type <= Queen; type++) {
+    collectTargets(&ctx, type);
+    results[count++] = measure(movegenNames[type], "ns/op",
+                               runGetPossibleMoves, &ctx, samples);
+  }
+
+  results[count++] =
+      measure("MovePiece+NextPlayer", "ns/op", runMovePiece, &ctx, samples);
+  results[count++] = measure("NewGame+DeleteGame", "ns/op", runNewDeleteGame,
+                             &ctx, samples);
+  results[count++] = measure("ResetDefaultConfiguration", "ns/op",
+                             runResetDefaultConfiguration, &ctx, samples);
+
+  ctx.next = 0;
+  results[count++] =
+      measure("SearchPosition/depth3", "ns/node", runSearch, &ctx, samples);
+
+  double nodesPerSecond = measureSearchSpeed(&ctx);
+
+  FILE *out = stdout;
+  if (outputPath != NULL && (out = fopen(outputPath, "w")) == NULL) {
+    fprintf(stderr, "Failed to open output '%s'\n", outputPath);
+    return 1;
+  }
+  writeResults(out, results, count, nodesPerSecond);
+  if (out != stdout)
+    fclose(out);
+
+  int regressions = 0;
+  if (baselinePath != NULL)
+    regressions = compareWithBaseline(baselinePath, results, count,
+                                      nodesPerSecond, threshold);
+
+  DeleteTranspositionTable(&ctx.tt);
+  free(ctx.search);
+  for (unsigned i = 0; i < ctx.gameCount; i++)
+    DeleteGame(ctx.games[i]);
+  DeleteGame(ctx.scratch);
+
+  return regressions != 0 ? 1 : 0;
+}
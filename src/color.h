@@ -1,3 +1,8 @@
 #include "raylib.h"
 
 const Color BoardSquareGreen = {0, 150, 0, 255};
+const Color PossibleTargetHighlight = {255, 220, 0, 110};
+const Color AnalysisArrow = {30, 100, 220, 200};
+const Color ExplorerWhiteWins = {235, 235, 235, 255};
+const Color ExplorerDraws = {150, 150, 150, 255};
+const Color ExplorerBlackWins = {40, 40, 40, 255};
@@ -0,0 +1,342 @@
+// Training data exporter for the evaluation tuner.
+//
+// Usage: ./datagen selfplay [--games N] [--threads N] [--depth N]
+//                           [--nodes N] [--random-plies N] --output file
+//        ./datagen pgn [--skip-plies N] --output file archive.pgn...
+//
+// Writes 32-byte PackedPosition records (see packed.h), streamed to disk as
+// games finish. Only quiet positions are kept: neither king is in check
+// and the move played is not a capture, so a static evaluation has a fair
+// chance of matching the game's outcome.
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "packed.h"
+#include "pgn.h"
+#include "search.h"
+#include "see.h"
+#include "tools.h"
+
+#define MAX_GAME_PLIES 400
+
+struct DataWriter {
+  FILE *file;
+  pthread_mutex_t lock;
+  unsigned long long positions;
+  unsigned long long games;
+};
+
+struct SelfPlay {
+  struct DataWriter *writer;
+  unsigned games;
+  int depth;
+  long long nodes;
+  unsigned randomPlies;
+  atomic_uint nextGame;
+};
+
+static bool appendPositions(struct DataWriter *writer,
+                            const struct PackedPosition *positions,
+                            size_t count) {
+  pthread_mutex_lock(&writer->lock);
+  bool ok =
+      fwrite(positions, sizeof(*positions), count, writer->file) == count;
+  writer->positions += count;
+  writer->games++;
+  pthread_mutex_unlock(&writer->lock);
+  return ok;
+}
+
+static uint64_t nextRandom(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// Plays a uniformly random legal move: one that leaves the mover's king out
+// of check. Returns false when there is none.
+static bool playRandomMove(struct Game *game, uint64_t *rng) {
+  enum Player mover = GetCurrentPlayer(game);
+  struct MovePicker picker;
+  struct Move moves[MAX_MOVES], move;
+  struct Undo undo;
+  unsigned count = 0;
+
+  InitPlainMovePicker(&picker, game);
+  while (NextMove(&picker, &move) && count < MAX_MOVES) {
+    MakeMove(game, move, &undo);
+    if (!IsInCheck(game, mover))
+      moves[count++] = move;
+    UnmakeMove(game, &undo);
+  }
+  if (count == 0)
+    return false;
+
+  MakeMove(game, moves[nextRandom(rng) % count], &undo);
+  return true;
+}
+
+// Plays one game from a randomised opening and appends its quiet positions
+// once the result is known
+static bool selfPlayGame(struct SelfPlay *s, struct Search *search,
+                         unsigned index, struct PackedPosition *buffer) {
+  struct Game *game = search->game;
+  uint64_t rng = 0x9E3779B97F4A7C15ULL * (index + 1);
+  uint64_t hashes[MAX_GAME_PLIES + 1];
+  enum GameResult result = ResultDraw;
+  size_t count = 0;
+  struct ResignTracker resign = {0};
+
+  ResetDefaultConfiguration(game);
+  for (unsigned i = 0; i < s->randomPlies; i++) {
+    if (!playRandomMove(game, &rng))
+      return true;
+  }
+  ClearTranspositionTable(search->tt);
+  ClearSearchHeuristics(&search->heuristics);
+  hashes[0] = GetPositionHash(game);
+
+  for (int ply = 0; ply < MAX_GAME_PLIES; ply++) {
+    struct SearchLimits limits = {.depth = s->depth, .nodes = s->nodes};
+    struct SearchResult found = SearchPosition(search, &limits);
+    if (IS_NULL_MOVE(found.bestMove))
+      break;
+
+    enum Player side = GetCurrentPlayer(game);
+    enum Player opponent = side == WhitePlayer ? BlackPlayer : WhitePlayer;
+    int whiteScore = side == WhitePlayer ? found.score : -found.score;
+    // The search is pseudo-legal and may have left its own king en prise;
+    // such a position cannot arise and must not reach the training data
+    if (!IsCaptureMove(game, found.bestMove) && !IsInCheck(game, side) &&
+        !IsInCheck(game, opponent))
+      PackPosition(game, ResultUnknown, s->randomPlies + ply, whiteScore,
+                   &buffer[count++]);
+
+    // Both engines are the same search, so a streak of decisive scores
+    // across consecutive plies settles the game
+    if (UpdateResignTracker(&resign, whiteScore)) {
+      result = whiteScore > 0 ? ResultWhiteWins : ResultBlackWins;
+      break;
+    }
+
+    struct Undo undo;
+    MakeMove(game, found.bestMove, &undo);
+    if (undo.captured != NULL && undo.captured->type == King) {
+      result = side == WhitePlayer ? ResultWhiteWins : ResultBlackWins;
+      break;
+    }
+    hashes[ply + 1] = GetPositionHash(game);
+    if (IsRepetition(hashes, ply + 1))
+      break;
+  }
+
+  uint8_t packedResult =
+      result == ResultWhiteWins ? 2 : result == ResultDraw ? 1 : 0;
+  for (size_t i = 0; i < count; i++)
+    buffer[i].result = packedResult;
+  return appendPositions(s->writer, buffer, count);
+}
+
+static void *selfPlayWorker(void *arg) {
+  struct SelfPlay *s = (struct SelfPlay *)arg;
+  struct Game *game = NewGame();
+  struct TranspositionTable tt = {0};
+  struct Search *search = (struct Search *)malloc(sizeof(struct Search));
+  struct PackedPosition *buffer = (struct PackedPosition *)malloc(
+      MAX_GAME_PLIES * sizeof(struct PackedPosition));
+  bool ok = game != NULL && search != NULL && buffer != NULL &&
+            NewTranspositionTable(&tt, 16);
+
+  if (ok)
+    InitSearch(search, game, &tt);
+  unsigned index;
+  while (ok && (index = atomic_fetch_add(&s->nextGame, 1)) < s->games) {
+    ok = selfPlayGame(s, search, index, buffer);
+    if (index % 100 == 99) {
+      printf("%u games\n", index + 1);
+      fflush(stdout);
+    }
+  }
+
+  DeleteTranspositionTable(&tt);
+  free(buffer);
+  free(search);
+  DeleteGame(game);
+  // The result travels back through pthread_join
+  return (void *)(uintptr_t)ok;
+}
+
+static int selfPlay(struct DataWriter *writer, int argc, char **argv) {
+  static struct SelfPlay s = {.games = 1000, .depth = 4, .randomPlies = 8};
+  unsigned threads = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+  s.writer = writer;
+
+  for (int i = 0; i + 1 < argc; i += 2) {
+    const char *value = argv[i + 1];
+    if (strcmp(argv[i], "--games") == 0)
+      s.games = (unsigned)atoi(value);
+    else if (strcmp(argv[i], "--threads") == 0)
+      threads = (unsigned)atoi(value);
+    else if (strcmp(argv[i], "--depth") == 0)
+      s.depth = atoi(value);
+    else if (strcmp(argv[i], "--nodes") == 0)
+      s.nodes = atoll(value);
+    else if (strcmp(argv[i], "--random-plies") == 0)
+      s.randomPlies = (unsigned)atoi(value);
+    else if (strcmp(argv[i], "--output") != 0) {
+      fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+      return 1;
+    }
+  }
+  if (threads == 0)
+    threads = 1;
+  atomic_init(&s.nextGame, 0);
+
+  pthread_t *workers = (pthread_t *)malloc(threads * sizeof(pthread_t));
+  if (workers == NULL)
+    return 1;
+  // Workers share the game counter, so the ones that start play every game
+  unsigned started = 0;
+  while (started < threads &&
+         pthread_create(&workers[started], NULL, selfPlayWorker, &s) == 0)
+    started++;
+  if (started < threads)
+    fprintf(stderr, "Started %u of %u worker threads\n", started, threads);
+  int status = started == 0;
+  for (unsigned i = 0; i < started; i++) {
+    void *ok;
+    pthread_join(workers[i], &ok);
+    if (!(uintptr_t)ok)
+      status = 1;
+  }
+  free(workers);
+  return status;
+}
+
+static bool exportArchive(struct DataWriter *writer, const char *path,
+                          unsigned skipPlies, struct Game *game,
+                          struct PackedPosition *buffer) {
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    fprintf(stderr, "Failed to open '%s'\n", path);
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return true;
+  }
+  const char *text =
+      (const char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (text == MAP_FAILED) {
+    fprintf(stderr, "Failed to map '%s'\n", path);
+    return false;
+  }
+  madvise((void *)text, st.st_size, MADV_SEQUENTIAL);
+
+  struct PgnGame pgn;
+  size_t offset = 0;
+  bool ok = true;
+  char token[32];
+  while (ok && NextPgnGame(text, st.st_size, &offset, &pgn)) {
+    if (pgn.result == ResultUnknown ||
+        (pgn.fen[0] != '\0' && !LoadFEN(game, pgn.fen)))
+      continue;
+    if (pgn.fen[0] == '\0')
+      ResetDefaultConfiguration(game);
+
+    // Games are cut at the first move the board cannot play
+    const char *cursor = pgn.movetext, *end = cursor + pgn.movetextLength;
+    size_t count = 0;
+    for (int ply = 0; ply < MAX_GAME_PLIES; ply++) {
+      struct Move move;
+      struct Undo undo;
+      if (!NextSanToken(&cursor, end, token, sizeof(token)) ||
+          !ParseSAN(game, token, &move))
+        break;
+
+      if ((unsigned)ply >= skipPlies && !IsCaptureMove(game, move) &&
+          !IsInCheck(game, GetCurrentPlayer(game)))
+        PackPosition(game, pgn.result, ply, PACKED_NO_SCORE,
+                     &buffer[count++]);
+      MakeMove(game, move, &undo);
+    }
+    ok = appendPositions(writer, buffer, count);
+  }
+
+  munmap((void *)text, st.st_size);
+  return ok;
+}
+
+static int exportPgn(struct DataWriter *writer, int argc, char **argv) {
+  unsigned skipPlies = 8;
+  int first = 0;
+  for (; first + 1 < argc && strncmp(argv[first], "--", 2) == 0; first += 2) {
+    if (strcmp(argv[first], "--skip-plies") == 0)
+      skipPlies = (unsigned)atoi(argv[first + 1]);
+    else if (strcmp(argv[first], "--output") != 0) {
+      fprintf(stderr, "Unknown option '%s'\n", argv[first]);
+      return 1;
+    }
+  }
+
+  struct Game *game = NewGame();
+  struct PackedPosition *buffer = (struct PackedPosition *)malloc(
+      MAX_GAME_PLIES * sizeof(struct PackedPosition));
+  bool ok = game != NULL && buffer != NULL;
+  for (int i = first; ok && i < argc; i++)
+    ok = exportArchive(writer, argv[i], skipPlies, game, buffer);
+
+  free(buffer);
+  DeleteGame(game);
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  const char *output = NULL;
+  for (int i = 2; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--output") == 0)
+      output = argv[i + 1];
+  }
+  bool selfplay = argc >= 2 && strcmp(argv[1], "selfplay") == 0;
+  bool pgn = argc >= 2 && strcmp(argv[1], "pgn") == 0;
+  if (output == NULL || (!selfplay && !pgn)) {
+    fprintf(stderr, "Usage: %s selfplay|pgn [options] --output file ...\n",
+            argv[0]);
+    return 1;
+  }
+
+  struct DataWriter writer = {.file = fopen(output, "wb")};
+  if (writer.file == NULL) {
+    fprintf(stderr, "Failed to open '%s'\n", output);
+    return 1;
+  }
+  // Large stdio buffer: records arrive one game at a time
+  setvbuf(writer.file, NULL, _IOFBF, 1 << 20);
+  pthread_mutex_init(&writer.lock, NULL);
+  SetTraceLogLevel(LOG_WARNING);
+
+  long long start = GetMonotonicTimeMs();
+  int status = selfplay ? selfPlay(&writer, argc - 2, argv + 2)
+                        : exportPgn(&writer, argc - 2, argv + 2);
+  if (fclose(writer.file) != 0)
+    status = 1;
+  double seconds = (GetMonotonicTimeMs() - start) / 1000.0;
+
+  printf("%llu positions from %llu games in %.1f s (%.0f positions/s), "
+         "%.1f MB\n",
+         writer.positions, writer.games, seconds,
+         seconds > 0 ? writer.positions / seconds : 0.0,
+         writer.positions * sizeof(struct PackedPosition) / 1e6);
+  pthread_mutex_destroy(&writer.lock);
+  return status;
+}
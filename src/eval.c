@@ -0,0 +1,168 @@
+#include "eval.h"
+
+#include <string.h>
+
+// Table names in enum PieceType order
+static const char *const pieceNames[6] = {
+    "pawn", "knight", "bishop", "king", "rook", "queen",
+};
+
+const struct EvalParams DefaultEvalParams = {
+    .material =
+        {
+            [Pawn] = 100,
+            [Knight] = 320,
+            [Bishop] = 330,
+            [King] = 0,
+            [Rook] = 500,
+            [Queen] = 900,
+        },
+    .pst =
+        {
+            [Pawn] =
+                {
+                    0,  0,  0,   0,   0,   0,   0,  0,  //
+                    50, 50, 50,  50,  50,  50,  50, 50, //
+                    10, 10, 20,  30,  30,  20,  10, 10, //
+                    5,  5,  10,  25,  25,  10,  5,  5,  //
+                    0,  0,  0,   20,  20,  0,   0,  0,  //
+                    5,  -5, -10, 0,   0,   -10, -5, 5,  //
+                    5,  10, 10,  -20, -20, 10,  10, 5,  //
+                    0,  0,  0,   0,   0,   0,   0,  0,  //
+                },
+            [Knight] =
+                {
+                    -50, -40, -30, -30, -30, -30, -40, -50, //
+                    -40, -20, 0,   0,   0,   0,   -20, -40, //
+                    -30, 0,   10,  15,  15,  10,  0,   -30, //
+                    -30, 5,   15,  20,  20,  15,  5,   -30, //
+                    -30, 0,   15,  20,  20,  15,  0,   -30, //
+                    -30, 5,   10,  15,  15,  10,  5,   -30, //
+                    -40, -20, 0,   5,   5,   0,   -20, -40, //
+                    -50, -40, -30, -30, -30, -30, -40, -50, //
+                },
+            [Bishop] =
+                {
+                    -20, -10, -10, -10, -10, -10, -10, -20, //
+                    -10, 0,   0,   0,   0,   0,   0,   -10, //
+                    -10, 0,   5,   10,  10,  5,   0,   -10, //
+                    -10, 5,   5,   10,  10,  5,   5,   -10, //
+                    -10, 0,   10,  10,  10,  10,  0,   -10, //
+                    -10, 10,  10,  10,  10,  10,  10,  -10, //
+                    -10, 5,   0,   0,   0,   0,   5,   -10, //
+                    -20, -10, -10, -10, -10, -10, -10, -20, //
+                },
+            [King] =
+                {
+                    -30, -40, -40, -50, -50, -40, -40, -30, //
+                    -30, -40, -40, -50, -50, -40, -40, -30, //
+                    -30, -40, -40, -50, -50, -40, -40, -30, //
+                    -30, -40, -40, -50, -50, -40, -40, -30, //
+                    -20, -30, -30, -40, -40, -30, -30, -20, //
+                    -10, -20, -20, -20, -20, -20, -20, -10, //
+                    20,  20,  0,   0,   0,   0,   20,  20,  //
+                    20,  30,  10,  0,   0,   10,  30,  20,  //
+                },
+            [Rook] =
+                {
+                    0,  0,  0,  0,  0,  0,  0,  0,  //
+                    5,  10, 10, 10, 10, 10, 10, 5,  //
+                    -5, 0,  0,  0,  0,  0,  0,  -5, //
+                    -5, 0,  0,  0,  0,  0,  0,  -5, //
+                    -5, 0,  0,  0,  0,  0,  0,  -5, //
+                    -5, 0,  0,  0,  0,  0,  0,  -5, //
+                    -5, 0,  0,  0,  0,  0,  0,  -5, //
+                    0,  0,  0,  5,  5,  0,  0,  0,  //
+                },
+            [Queen] =
+                {
+                    -20, -10, -10, -5, -5, -10, -10, -20, //
+                    -10, 0,   0,   0,  0,  0,   0,   -10, //
+                    -10, 0,   5,   5,  5,  5,   0,   -10, //
+                    -5,  0,   5,   5,  5,  5,   0,   -5,  //
+                    0,   0,   5,   5,  5,  5,   0,   -5,  //
+                    -10, 5,   5,   5,  5,  5,   0,   -10, //
+                    -10, 0,   5,   0,  0,  0,   0,   -10, //
+                    -20, -10, -10, -5, -5, -10, -10, -20, //
+                },
+        },
+};
+
+// Material plus piece-square score in centipawns, from the point of view of
+// the side to move
+int EvaluateWith(const struct EvalParams *params, const struct Game *game) {
+  int score = 0;
+
+  for (int x = 0; x < 8; x++) {
+    for (int y = 0; y < 8; y++) {
+      const struct Piece *p = game->board->pieces[x][y];
+      if (p == NULL)
+        continue;
+
+      int value = params->material[p->type] +
+                  params->pst[p->type][PST_INDEX(p->player, x, y)];
+      score += p->player == WhitePlayer ? value : -value;
+    }
+  }
+
+  return GetCurrentPlayer(game) == WhitePlayer ? score : -score;
+}
+
+int Evaluate(const struct Game *game) {
+  return EvaluateWith(&DefaultEvalParams, game);
+}
+
+bool LoadEvalParams(struct EvalParams *params, const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    TraceLog(LOG_ERROR, "Failed to open evaluation parameters '%s'", path);
+    return false;
+  }
+
+  *params = DefaultEvalParams;
+  char word[32];
+  bool ok = true;
+  while (ok && fscanf(file, "%31s", word) == 1) {
+    if (word[0] == '#') {
+      fscanf(file, "%*[^\n]");
+    } else if (strcmp(word, "material") == 0) {
+      for (int t = 0; ok && t < 6; t++)
+        ok = fscanf(file, "%d", &params->material[t]) == 1;
+    } else if (strcmp(word, "pst") == 0 && fscanf(file, "%31s", word) == 1) {
+      int t = 0;
+      while (t < 6 && strcmp(word, pieceNames[t]) != 0)
+        t++;
+      ok = t < 6;
+      for (int i = 0; ok && i < 64; i++)
+        ok = fscanf(file, "%d", &params->pst[t][i]) == 1;
+    } else {
+      ok = false;
+    }
+  }
+  fclose(file);
+
+  if (!ok)
+    TraceLog(LOG_ERROR, "Malformed evaluation parameters '%s'", path);
+  return ok;
+}
+
+bool SaveEvalParams(const struct EvalParams *params, const char *path) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    TraceLog(LOG_ERROR, "Failed to write evaluation parameters '%s'", path);
+    return false;
+  }
+
+  fprintf(file, "# Centipawns; tables as seen by white, rank 8 first\n");
+  fprintf(file, "material");
+  for (int t = 0; t < 6; t++)
+    fprintf(file, " %d", params->material[t]);
+  fprintf(file, "\n");
+
+  for (int t = 0; t < 6; t++) {
+    fprintf(file, "pst %s\n", pieceNames[t]);
+    for (int i = 0; i < 64; i++)
+      fprintf(file, "%5d%s", params->pst[t][i], i % 8 == 7 ? "\n" : "");
+  }
+  return fclose(file) == 0;
+}
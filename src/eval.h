@@ -0,0 +1,26 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "game.h"
+
+// Piece-square tables are laid out as seen by white, rank 8 first, so black
+// reads them mirrored vertically
+#define PST_INDEX(player, x, y)                                                \
+  ((((player) == WhitePlayer) ? (y) : 7 - (y)) * BOARD_SIZE + (x))
+
+struct EvalParams {
+  int material[6];
+  int pst[6][64];
+};
+
+extern const struct EvalParams DefaultEvalParams;
+
+int Evaluate(const struct Game *game);
+int EvaluateWith(const struct EvalParams *params, const struct Game *game);
+
+// Text format: "material" followed by six values, then "pst <piece>"
+// followed by 64 values per table. Anything missing keeps its default.
+bool LoadEvalParams(struct EvalParams *params, const char *path);
+bool SaveEvalParams(const struct EvalParams *params, const char *path);
+
+#endif // EVAL_H
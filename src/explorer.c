@@ -0,0 +1,126 @@
+#include "explorer.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Maps the database read-only. Only the index is read up front, to check
+// that queries can trust it for bounds; entry pages are faulted in by the
+// queries that touch them.
+bool OpenExplorer(struct Explorer *explorer, const char *path) {
+  memset(explorer, 0, sizeof(*explorer));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    TraceLog(LOG_ERROR, "Failed to open explorer database '%s'", path);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      (size_t)st.st_size < sizeof(struct ExplorerHeader)) {
+    TraceLog(LOG_ERROR, "'%s' is not an explorer database", path);
+    close(fd);
+    return false;
+  }
+
+  void *data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    TraceLog(LOG_ERROR, "Failed to map explorer database '%s'", path);
+    return false;
+  }
+  madvise(data, st.st_size, MADV_RANDOM);
+
+  const struct ExplorerHeader *header = (const struct ExplorerHeader *)data;
+  bool valid = memcmp(header->magic, EXPLORER_MAGIC, 4) == 0 &&
+               header->version == EXPLORER_VERSION &&
+               header->byteOrder == EXPLORER_BYTE_ORDER &&
+               header->indexBits <= 32;
+  size_t entriesSize = header->entryCount * sizeof(struct ExplorerEntry);
+  size_t indexSize = valid ? (((size_t)1 << header->indexBits) + 1) *
+                                 sizeof(uint64_t)
+                           : 0;
+  if (!valid ||
+      (size_t)st.st_size != sizeof(*header) + entriesSize + indexSize) {
+    TraceLog(LOG_ERROR, "'%s' is not a compatible explorer database", path);
+    munmap(data, st.st_size);
+    return false;
+  }
+
+  const uint64_t *index =
+      (const uint64_t *)((const unsigned char *)data + sizeof(*header) +
+                         entriesSize);
+  size_t buckets = (size_t)1 << header->indexBits;
+  for (size_t b = 0; valid && b < buckets; b++)
+    valid = index[b] <= index[b + 1];
+  if (!valid || index[buckets] != header->entryCount) {
+    TraceLog(LOG_ERROR, "'%s' has a corrupt index", path);
+    munmap(data, st.st_size);
+    return false;
+  }
+
+  explorer->data = (const unsigned char *)data;
+  explorer->size = st.st_size;
+  explorer->header = header;
+  explorer->entries =
+      (const struct ExplorerEntry *)(explorer->data + sizeof(*header));
+  explorer->index = index;
+  TraceLog(LOG_INFO, "Explorer database '%s': %llu positions, %llu games",
+           path, (unsigned long long)header->positionCount,
+           (unsigned long long)header->gameCount);
+  return true;
+}
+
+void CloseExplorer(struct Explorer *explorer) {
+  if (explorer->data != NULL)
+    munmap((void *)explorer->data, explorer->size);
+  memset(explorer, 0, sizeof(*explorer));
+}
+
+static uint32_t gameCount(const struct ExplorerMove *move) {
+  return move->white + move->draws + move->black;
+}
+
+unsigned QueryExplorer(const struct Explorer *explorer, uint64_t key,
+                       struct ExplorerMove *moves, unsigned maxMoves) {
+  unsigned bits = explorer->header->indexBits;
+  uint64_t bucket = bits == 0 ? 0 : key >> (64 - bits);
+  uint64_t lo = explorer->index[bucket], hi = explorer->index[bucket + 1];
+
+  // Zobrist keys are uniform, so a bucket holds a handful of entries and
+  // the binary search settles in a few probes
+  while (lo < hi) {
+    uint64_t mid = lo + (hi - lo) / 2;
+    if (explorer->entries[mid].key < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  unsigned count = 0;
+  uint64_t end = explorer->index[bucket + 1];
+  for (uint64_t i = lo; i < end && explorer->entries[i].key == key; i++) {
+    const struct ExplorerEntry *entry = &explorer->entries[i];
+    struct ExplorerMove move = {
+        .move = {EXPLORER_MOVE_FROM(entry->move),
+                 EXPLORER_MOVE_TO(entry->move)},
+        .white = entry->white,
+        .draws = entry->draws,
+        .black = entry->black,
+    };
+
+    // Insertion by popularity, keeping the best maxMoves
+    unsigned at = count < maxMoves ? count++ : maxMoves;
+    while (at > 0 && gameCount(&moves[at - 1]) < gameCount(&move)) {
+      if (at < maxMoves)
+        moves[at] = moves[at - 1];
+      at--;
+    }
+    if (at < maxMoves)
+      moves[at] = move;
+  }
+  return count;
+}
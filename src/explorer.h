@@ -0,0 +1,62 @@
+#ifndef EXPLORER_H
+#define EXPLORER_H
+
+#include "game.h"
+
+#define EXPLORER_MAGIC "CEXP"
+#define EXPLORER_VERSION 1
+#define EXPLORER_BYTE_ORDER 0x01020304u
+
+// The database file is mapped as-is, so the header and entries are laid out
+// exactly like these structs:
+//   header | entries sorted by (key, move) | index
+// The index holds 2^indexBits + 1 entry offsets; bucket b covers the keys
+// whose top indexBits bits equal b.
+struct ExplorerHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t indexBits;
+  uint64_t entryCount;
+  uint64_t gameCount;
+  uint64_t positionCount;
+  uint64_t reserved[3];
+};
+
+// One move played from one position, with the results of those games
+struct ExplorerEntry {
+  uint64_t key;
+  uint16_t move;
+  uint16_t reserved;
+  uint32_t white;
+  uint32_t draws;
+  uint32_t black;
+};
+
+#define EXPLORER_MOVE(from, to) ((uint16_t)((from) | (to) << 6))
+#define EXPLORER_MOVE_FROM(m) ((m) & 63)
+#define EXPLORER_MOVE_TO(m) ((m) >> 6 & 63)
+
+struct ExplorerMove {
+  struct Move move;
+  uint32_t white;
+  uint32_t draws;
+  uint32_t black;
+};
+
+struct Explorer {
+  const unsigned char *data;
+  size_t size;
+  const struct ExplorerHeader *header;
+  const struct ExplorerEntry *entries;
+  const uint64_t *index;
+};
+
+bool OpenExplorer(struct Explorer *explorer, const char *path);
+void CloseExplorer(struct Explorer *explorer);
+// Fills `moves` with the moves played from the position, most played first,
+// and returns how many were written
+unsigned QueryExplorer(const struct Explorer *explorer, uint64_t key,
+                       struct ExplorerMove *moves, unsigned maxMoves);
+
+#endif // EXPLORER_H
@@ -1,6 +1,43 @@
 #include "game.h"
 #include <raylib.h>
 
+// Zobrist keys are derived on the fly from a fixed mixer, so hashes are
+// stable across runs and the keys need no shared initialisation
+static uint64_t splitmix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+static uint64_t zobristPieceKey(const struct Piece *piece, int square) {
+  return splitmix64(((uint64_t)(piece->player * 6 + piece->type) << 6) |
+                    (uint64_t)square);
+}
+
+static uint64_t zobristSideKey() { return splitmix64(2 * 6 * 64); }
+
+static uint64_t computeHash(const struct Game *game) {
+  uint64_t hash = 0;
+  for (int x = 0; x < 8; x++) {
+    for (int y = 0; y < 8; y++) {
+      const struct Piece *p = game->board->pieces[x][y];
+      if (p != NULL)
+        hash ^= zobristPieceKey(p, SQUARE_INDEX(x, y));
+    }
+  }
+  if (game->_currentPlayer == BlackPlayer)
+    hash ^= zobristSideKey();
+  return hash;
+}
+
+static void hashPieceMove(struct Game *game, const struct Piece *piece,
+                          const struct Piece *captured, int from, int to) {
+  game->_hash ^= zobristPieceKey(piece, from) ^ zobristPieceKey(piece, to);
+  if (captured != NULL)
+    game->_hash ^= zobristPieceKey(captured, to);
+}
+
 struct Game *NewGame() {
   TraceLog(LOG_DEBUG, "Allocating game structure");
   struct Game *game = (struct Game *)malloc(sizeof(struct Game));
@@ -84,6 +121,37 @@ void DeleteGame(struct Game *game) {
   TraceLog(LOG_DEBUG, "Game deletion complete");
 }
 
+static struct Piece *translatePiece(struct Game *dst, const struct Game *src,
+                                    const struct Piece *piece) {
+  if (piece == NULL)
+    return NULL;
+  if (piece >= src->_whitePieces && piece < src->_whitePieces + 16)
+    return &dst->_whitePieces[piece - src->_whitePieces];
+  return &dst->_blackPieces[piece - src->_blackPieces];
+}
+
+// Copies the position of `src` into a game created with NewGame. The board
+// holds pointers into the piece arrays, so they are re-targeted at `dst`.
+void CopyGame(struct Game *dst, const struct Game *src) {
+  TraceLog(LOG_DEBUG, "Copying game structure");
+  for (int i = 0; i < 16; i++) {
+    dst->_whitePieces[i] = src->_whitePieces[i];
+    dst->_blackPieces[i] = src->_blackPieces[i];
+  }
+  for (int x = 0; x < 8; x++) {
+    for (int y = 0; y < 8; y++) {
+      dst->board->pieces[x][y] =
+          translatePiece(dst, src, src->board->pieces[x][y]);
+    }
+  }
+
+  dst->_currentPlayer = src->_currentPlayer;
+  dst->_hash = src->_hash;
+  for (int i = 0; i < 64; i++)
+    dst->_possibleTargets[i] = src->_possibleTargets[i];
+  dst->_possibleTargetsHash = src->_possibleTargetsHash;
+}
+
 void resetPlayerPieces(struct Game *game, enum Player player,
                        struct Piece *pieces) {
   int x = 0, y;
@@ -185,10 +253,112 @@ void ResetDefaultConfiguration(struct Game *game) {
 
   TraceLog(LOG_DEBUG, "Setting current player to WhitePlayer");
   game->_currentPlayer = WhitePlayer;
+  game->_hash = computeHash(game);
+  RefreshPossibleTargets(game);
 
   TraceLog(LOG_DEBUG, "Game reset complete");
 }
 
+static bool pieceTypeFromChar(char c, enum PieceType *type) {
+  switch (c) {
+  case PAWN:
+    *type = Pawn;
+    return true;
+  case KNIGHT:
+    *type = Knight;
+    return true;
+  case BISHOP:
+    *type = Bishop;
+    return true;
+  case ROOK:
+    *type = Rook;
+    return true;
+  case QUEEN:
+    *type = Queen;
+    return true;
+  case KING:
+    *type = King;
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Loads the placement and side-to-move fields of a FEN string. Rank 8 maps
+// to y = 0, so white keeps moving up the screen as in the default setup.
+// Castling, en passant and move clocks are ignored because the move
+// generator does not support them.
+bool LoadFEN(struct Game *game, const char *fen) {
+  if (game == NULL || fen == NULL) {
+    TraceLog(LOG_ERROR, "Invalid parameters passed to LoadFEN");
+    return false;
+  }
+
+  struct Piece *placed[8][8] = {{NULL}};
+  unsigned counts[2] = {0, 0};
+  int x = 0, y = 0;
+  const char *c = fen;
+
+  for (; *c != '\0' && *c != ' '; c++) {
+    if (*c == '/') {
+      if (x != 8 || ++y >= 8) {
+        TraceLog(LOG_ERROR, "Malformed FEN rank separator in '%s'", fen);
+        return false;
+      }
+      x = 0;
+    } else if (*c >= '1' && *c <= '8') {
+      x += *c - '0';
+    } else {
+      enum PieceType type;
+      enum Player player =
+          (*c >= 'a' && *c <= 'z') ? BlackPlayer : WhitePlayer;
+      char upper = player == BlackPlayer ? *c - 32 : *c;
+      if (!pieceTypeFromChar(upper, &type) || x >= 8 || counts[player] >= 16) {
+        TraceLog(LOG_ERROR, "Unsupported FEN piece '%c' in '%s'", *c, fen);
+        return false;
+      }
+      struct Piece *pieces =
+          player == WhitePlayer ? game->_whitePieces : game->_blackPieces;
+      struct Piece *piece = &pieces[counts[player]++];
+      int pawnRowY = (player == WhitePlayer) ? 6 : 1;
+      *piece = (struct Piece){
+          .player = player,
+          .type = type,
+          .square = (Vector2){x, y},
+          .pos = (Vector2){x * (float)SQUARE_SIZE, y * (float)SQUARE_SIZE},
+          .moveCounter = (type == Pawn && y != pawnRowY) ? 1 : 0,
+      };
+      placed[x][y] = piece;
+      x++;
+    }
+    if (x > 8) {
+      TraceLog(LOG_ERROR, "FEN rank overflow in '%s'", fen);
+      return false;
+    }
+  }
+  if (x != 8 || y != 7) {
+    TraceLog(LOG_ERROR, "FEN placement is incomplete in '%s'", fen);
+    return false;
+  }
+
+  for (x = 0; x < 8; x++) {
+    for (y = 0; y < 8; y++) {
+      game->board->pieces[x][y] = placed[x][y];
+    }
+  }
+
+  while (*c == ' ')
+    c++;
+  game->_currentPlayer = (*c == 'b') ? BlackPlayer : WhitePlayer;
+  game->_hash = computeHash(game);
+  RefreshPossibleTargets(game);
+
+  TraceLog(LOG_DEBUG, "Loaded FEN '%s'", fen);
+  return true;
+}
+
+uint64_t GetPositionHash(const struct Game *game) { return game->_hash; }
+
 struct Piece *GetPieceInXYPosition(const struct Game *game, unsigned x,
                                    unsigned y) {
   return game->board->pieces[x][y];
@@ -207,12 +377,70 @@ enum Player NextPlayer(struct Game *game) {
     game->_currentPlayer = WhitePlayer;
     TraceLog(LOG_DEBUG, "Switching to WhitePlayer");
   }
+  game->_hash ^= zobristSideKey();
+  RefreshPossibleTargets(game);
 
   TraceLog(LOG_DEBUG, "Current player: %s",
            (game->_currentPlayer == WhitePlayer ? "White" : "Black"));
   return game->_currentPlayer;
 }
 
+static uint64_t possibleMovesMask(const struct Game *game, const Vector2 *pos) {
+  struct Moves moves = GetPossibleMoves(game, pos);
+  uint64_t mask = 0;
+  for (unsigned i = 0; i < moves.size; i++) {
+    mask |= 1ULL << SQUARE_INDEX((int)moves.squares[i].x,
+                                 (int)moves.squares[i].y);
+  }
+  return mask;
+}
+
+// Generates every move of the side to move once per position so the UI can
+// highlight and validate targets without calling GetPossibleMoves again. The
+// targets are pseudo-legal: some may leave the mover's own king in check.
+void RefreshPossibleTargets(struct Game *game) {
+  TraceLog(LOG_DEBUG, "Refreshing possible target cache");
+  for (int x = 0; x < 8; x++) {
+    for (int y = 0; y < 8; y++) {
+      struct Piece *p = game->board->pieces[x][y];
+      game->_possibleTargets[SQUARE_INDEX(x, y)] =
+          (p != NULL && p->player == game->_currentPlayer)
+              ? possibleMovesMask(game, &p->square)
+              : 0;
+    }
+  }
+  game->_possibleTargetsHash = game->_hash;
+}
+
+// Targets of the piece on `pos` if it belongs to the side to move. A cache
+// left behind by a position change (e.g. MakeMove in search) is bypassed
+// rather than trusted.
+uint64_t GetPossibleTargets(const struct Game *game, const Vector2 *pos) {
+  if ((unsigned)pos->x >= game->board->size ||
+      (unsigned)pos->y >= game->board->size)
+    return 0;
+
+  const struct Piece *piece = game->board->pieces[(int)pos->x][(int)pos->y];
+  if (piece == NULL || piece->player != game->_currentPlayer)
+    return 0;
+
+  if (game->_possibleTargetsHash == game->_hash)
+    return game->_possibleTargets[SQUARE_INDEX((int)pos->x, (int)pos->y)];
+
+  TraceLog(LOG_DEBUG, "Possible target cache is stale, generating moves");
+  return possibleMovesMask(game, pos);
+}
+
+bool IsPossibleTarget(const struct Game *game, const Vector2 *from,
+                      const Vector2 *to) {
+  if ((unsigned)to->x >= game->board->size ||
+      (unsigned)to->y >= game->board->size)
+    return false;
+
+  uint64_t targets = GetPossibleTargets(game, from);
+  return (targets >> SQUARE_INDEX((int)to->x, (int)to->y)) & 1;
+}
+
 #include <stdio.h>
 
 bool MovePiece(struct Game *game, const Vector2 *curPos, const Vector2 *pos) {
@@ -241,16 +469,21 @@ bool MovePiece(struct Game *game, const Vector2 *curPos, const Vector2 *pos) {
     return false;
   }
 
-  struct Moves moves = GetPossibleMoves(game, &piece->square);
   bool validMove = false;
-  for (int i = 0; i < moves.size; i++) {
-    if (moves.squares[i].x == pos->x && moves.squares[i].y == pos->y) {
-      TraceLog(LOG_DEBUG, "Valid move");
-      validMove = true;
-      break;
+  if (piece->player == game->_currentPlayer) {
+    validMove = IsPossibleTarget(game, &oldPos, pos);
+  } else {
+    struct Moves moves = GetPossibleMoves(game, &piece->square);
+    for (int i = 0; i < moves.size; i++) {
+      if (moves.squares[i].x == pos->x && moves.squares[i].y == pos->y) {
+        validMove = true;
+        break;
+      }
     }
   }
-  if (!validMove) {
+  if (validMove) {
+    TraceLog(LOG_DEBUG, "Valid move");
+  } else {
     TraceLog(LOG_DEBUG, "Invalid moves");
     return false;
   }
@@ -264,6 +497,10 @@ bool MovePiece(struct Game *game, const Vector2 *curPos, const Vector2 *pos) {
   PrintFormattedBoard(game);
 #endif
 
+  hashPieceMove(game, piece,
+                game->board->pieces[(unsigned)pos->x][(unsigned)pos->y],
+                SQUARE_INDEX((int)oldPos.x, (int)oldPos.y),
+                SQUARE_INDEX((int)pos->x, (int)pos->y));
   game->board->pieces[(unsigned)pos->x][(unsigned)pos->y] = piece;
   game->board->pieces[(unsigned)oldPos.x][(unsigned)oldPos.y] = NULL;
 
@@ -278,6 +515,45 @@ bool MovePiece(struct Game *game, const Vector2 *curPos, const Vector2 *pos) {
   return true;
 }
 
+// Applies a move without validation and passes the turn. Unlike MovePiece
+// it leaves the piece's screen position alone, so it is cheap enough for
+// search; UnmakeMove restores the position exactly.
+void MakeMove(struct Game *game, struct Move move, struct Undo *undo) {
+  int fromX = SQUARE_X(move.from), fromY = SQUARE_Y(move.from);
+  int toX = SQUARE_X(move.to), toY = SQUARE_Y(move.to);
+  struct Piece *piece = game->board->pieces[fromX][fromY];
+
+  undo->move = move;
+  undo->captured = game->board->pieces[toX][toY];
+  undo->hash = game->_hash;
+
+  hashPieceMove(game, piece, undo->captured, move.from, move.to);
+  game->_hash ^= zobristSideKey();
+
+  game->board->pieces[toX][toY] = piece;
+  game->board->pieces[fromX][fromY] = NULL;
+  piece->square = (Vector2){toX, toY};
+  piece->moveCounter++;
+
+  game->_currentPlayer =
+      game->_currentPlayer == WhitePlayer ? BlackPlayer : WhitePlayer;
+}
+
+void UnmakeMove(struct Game *game, const struct Undo *undo) {
+  int fromX = SQUARE_X(undo->move.from), fromY = SQUARE_Y(undo->move.from);
+  int toX = SQUARE_X(undo->move.to), toY = SQUARE_Y(undo->move.to);
+  struct Piece *piece = game->board->pieces[toX][toY];
+
+  game->board->pieces[fromX][fromY] = piece;
+  game->board->pieces[toX][toY] = undo->captured;
+  piece->square = (Vector2){fromX, fromY};
+  piece->moveCounter--;
+
+  game->_currentPlayer =
+      game->_currentPlayer == WhitePlayer ? BlackPlayer : WhitePlayer;
+  game->_hash = undo->hash;
+}
+
 // Function to get character representation for a piece
 char getPieceChar(const struct Piece *piece) {
   if (piece == NULL)
@@ -8,6 +8,7 @@
 #define DEBUG_MODE
 // #define PRINT_BOARD
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -41,19 +42,46 @@ struct Board {
 };
 
 struct Moves {
-  Vector2 squares[21];
+  // A queen in the centre of an empty board reaches 27 squares
+  Vector2 squares[27];
   unsigned size;
 };
 
+// Squares are packed as x * BOARD_SIZE + y, matching board->pieces[x][y]
+#define SQUARE_INDEX(x, y) ((x) * BOARD_SIZE + (y))
+#define SQUARE_X(sq) ((sq) / BOARD_SIZE)
+#define SQUARE_Y(sq) ((sq) % BOARD_SIZE)
+
+struct Move {
+  unsigned char from;
+  unsigned char to;
+};
+
+#define NULL_MOVE ((struct Move){0, 0})
+#define IS_NULL_MOVE(m) ((m).from == (m).to)
+#define SAME_MOVE(a, b) ((a).from == (b).from && (a).to == (b).to)
+
+struct Undo {
+  struct Move move;
+  struct Piece *captured;
+  uint64_t hash;
+};
+
 struct Game {
   struct Board *board;
   struct Piece _whitePieces[16];
   struct Piece _blackPieces[16];
   enum Player _currentPlayer;
+  uint64_t _hash;
+  // Pseudo-legal destination bitmask per origin square for the side to
+  // move, valid while _possibleTargetsHash matches _hash
+  uint64_t _possibleTargets[64];
+  uint64_t _possibleTargetsHash;
 };
 
 struct Game *NewGame();
 void DeleteGame(struct Game *game);
+void CopyGame(struct Game *dst, const struct Game *src);
 void ResetDefaultConfiguration(struct Game *game);
 struct Piece *GetPieceInXYPosition(const struct Game *game, unsigned x,
                                    unsigned y);
@@ -61,6 +89,14 @@ bool MovePiece(struct Game *game, const Vector2 *curPos, const Vector2 *pos);
 enum Player GetCurrentPlayer(const struct Game *game);
 enum Player NextPlayer(struct Game *Game);
 struct Moves GetPossibleMoves(const struct Game *game, const Vector2 *pos);
+bool LoadFEN(struct Game *game, const char *fen);
+uint64_t GetPositionHash(const struct Game *game);
+void RefreshPossibleTargets(struct Game *game);
+uint64_t GetPossibleTargets(const struct Game *game, const Vector2 *pos);
+bool IsPossibleTarget(const struct Game *game, const Vector2 *from,
+                      const Vector2 *to);
+void MakeMove(struct Game *game, struct Move move, struct Undo *undo);
+void UnmakeMove(struct Game *game, const struct Undo *undo);
 
 #define WHITE_PLAYER 'W'
 #define BLACK_PLAYER 'B'
@@ -0,0 +1,145 @@
+#include "input.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// File layout, all little endian:
+//   header: "CREC", u16 version, u16 reserved, u32 frame count, u64 hash
+//   frame:  i16 mouse x, i16 mouse y, u8 buttons, u8 key count, u16 keys[]
+// The frame count and hash are patched in when the recorder is closed.
+#define RECORDING_MAGIC "CREC"
+#define RECORDING_VERSION 1
+#define RECORDING_HEADER_SIZE 20
+
+static void putU16(unsigned char *out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = value >> 8;
+}
+
+static uint16_t getU16(const unsigned char *in) {
+  return (uint16_t)(in[0] | in[1] << 8);
+}
+
+static void writeHeader(FILE *file, uint32_t frameCount, uint64_t hash) {
+  unsigned char header[RECORDING_HEADER_SIZE] = {0};
+  memcpy(header, RECORDING_MAGIC, 4);
+  putU16(header + 4, RECORDING_VERSION);
+  for (int i = 0; i < 4; i++)
+    header[8 + i] = (frameCount >> (8 * i)) & 0xFF;
+  for (int i = 0; i < 8; i++)
+    header[12 + i] = (hash >> (8 * i)) & 0xFF;
+  fwrite(header, 1, sizeof(header), file);
+}
+
+bool OpenInputRecorder(struct InputRecorder *recorder, const char *path) {
+  recorder->frameCount = 0;
+  recorder->file = fopen(path, "wb");
+  if (recorder->file == NULL) {
+    TraceLog(LOG_ERROR, "Failed to open input recording '%s'", path);
+    return false;
+  }
+
+  writeHeader(recorder->file, 0, 0);
+  TraceLog(LOG_INFO, "Recording input to '%s'", path);
+  return true;
+}
+
+void RecordInputFrame(struct InputRecorder *recorder,
+                      const struct InputFrame *frame) {
+  if (recorder->file == NULL)
+    return;
+
+  unsigned char buffer[6 + 2 * INPUT_MAX_KEYS];
+  unsigned keyCount =
+      frame->keyCount < INPUT_MAX_KEYS ? frame->keyCount : INPUT_MAX_KEYS;
+
+  putU16(buffer, (uint16_t)(int16_t)frame->mouseX);
+  putU16(buffer + 2, (uint16_t)(int16_t)frame->mouseY);
+  buffer[4] = frame->buttons;
+  buffer[5] = (unsigned char)keyCount;
+  for (unsigned i = 0; i < keyCount; i++)
+    putU16(buffer + 6 + 2 * i, (uint16_t)frame->keys[i]);
+
+  fwrite(buffer, 1, 6 + 2 * keyCount, recorder->file);
+  recorder->frameCount++;
+}
+
+void CloseInputRecorder(struct InputRecorder *recorder, uint64_t finalHash) {
+  if (recorder->file == NULL)
+    return;
+
+  fseek(recorder->file, 0, SEEK_SET);
+  writeHeader(recorder->file, recorder->frameCount, finalHash);
+  fclose(recorder->file);
+  recorder->file = NULL;
+
+  TraceLog(LOG_INFO, "Recorded %u input frames", recorder->frameCount);
+}
+
+bool LoadInputRecording(struct InputRecording *recording, const char *path) {
+  unsigned char header[RECORDING_HEADER_SIZE];
+  recording->frames = NULL;
+  recording->frameCount = 0;
+
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    TraceLog(LOG_ERROR, "Failed to open input recording '%s'", path);
+    return false;
+  }
+
+  if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+      memcmp(header, RECORDING_MAGIC, 4) != 0 ||
+      getU16(header + 4) != RECORDING_VERSION) {
+    TraceLog(LOG_ERROR, "'%s' is not an input recording", path);
+    fclose(file);
+    return false;
+  }
+
+  uint32_t frameCount = 0;
+  uint64_t hash = 0;
+  for (int i = 0; i < 4; i++)
+    frameCount |= (uint32_t)header[8 + i] << (8 * i);
+  for (int i = 0; i < 8; i++)
+    hash |= (uint64_t)header[12 + i] << (8 * i);
+
+  recording->frames =
+      (struct InputFrame *)calloc(frameCount ? frameCount : 1,
+                                  sizeof(struct InputFrame));
+  if (recording->frames == NULL) {
+    TraceLog(LOG_ERROR, "Failed to allocate %u input frames", frameCount);
+    fclose(file);
+    return false;
+  }
+
+  for (uint32_t f = 0; f < frameCount; f++) {
+    unsigned char buffer[6 + 2 * INPUT_MAX_KEYS];
+    struct InputFrame *frame = &recording->frames[f];
+
+    if (fread(buffer, 1, 6, file) != 6 || buffer[5] > INPUT_MAX_KEYS ||
+        fread(buffer + 6, 2, buffer[5], file) != buffer[5]) {
+      TraceLog(LOG_ERROR, "Input recording '%s' is truncated at frame %u",
+               path, f);
+      UnloadInputRecording(recording);
+      fclose(file);
+      return false;
+    }
+
+    frame->mouseX = (int16_t)getU16(buffer);
+    frame->mouseY = (int16_t)getU16(buffer + 2);
+    frame->buttons = buffer[4];
+    frame->keyCount = buffer[5];
+    for (unsigned i = 0; i < frame->keyCount; i++)
+      frame->keys[i] = getU16(buffer + 6 + 2 * i);
+  }
+
+  fclose(file);
+  recording->frameCount = frameCount;
+  recording->finalHash = hash;
+  return true;
+}
+
+void UnloadInputRecording(struct InputRecording *recording) {
+  free(recording->frames);
+  recording->frames = NULL;
+  recording->frameCount = 0;
+}
@@ -0,0 +1,46 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "raylib.h"
+
+#define INPUT_MAX_KEYS 8
+
+// Left mouse button state bits
+#define INPUT_LEFT_PRESSED 0x01
+#define INPUT_LEFT_RELEASED 0x02
+#define INPUT_LEFT_DOWN 0x04
+
+// Everything update() reads in one frame, so it can be driven either by the
+// window or by a recording
+struct InputFrame {
+  float mouseX;
+  float mouseY;
+  unsigned char buttons;
+  unsigned char keyCount;
+  int keys[INPUT_MAX_KEYS];
+};
+
+struct InputRecorder {
+  FILE *file;
+  uint32_t frameCount;
+};
+
+struct InputRecording {
+  struct InputFrame *frames;
+  uint32_t frameCount;
+  // Position hash at the end of the session, used to check determinism
+  uint64_t finalHash;
+};
+
+bool OpenInputRecorder(struct InputRecorder *recorder, const char *path);
+void RecordInputFrame(struct InputRecorder *recorder,
+                      const struct InputFrame *frame);
+void CloseInputRecorder(struct InputRecorder *recorder, uint64_t finalHash);
+
+bool LoadInputRecording(struct InputRecording *recording, const char *path);
+void UnloadInputRecording(struct InputRecording *recording);
+
+#endif // INPUT_H
@@ -1,12 +1,12 @@
+#include <math.h>
+#include <string.h>
+
 #include "color.h"
 #include "game.h"
+#include "input.h"
+#include "pgn.h"
 #include "raylib.h"
-
-#define WINDOW_WIDTH 640
-#define WINDOW_HEIGHT 640
-
-struct Piece *selected = NULL;
-struct Game *game = NULL;
+#include "ui.h"
 
 static Texture2D _whitePieceTextures[6];
 static Texture2D _blackPieceTextures[6];
@@ -62,21 +62,6 @@ void LoadGameTextures() {
   }
 }
 
-Vector2 GetSquareOverlabByTheCursor() {
-  float mouseX = GetMouseX();
-  float mouseY = GetMouseY();
-
-  Vector2 pos = (Vector2){
-      .x = (int)(mouseX / SQUARE_SIZE),
-      .y = (int)(mouseY / SQUARE_SIZE),
-  };
-
-  TraceLog(LOG_DEBUG,
-           "Raw Mouse position: (%d, %d) - Square position: (%d, %d)",
-           (int)mouseX, (int)mouseY, (int)pos.x, (int)pos.y);
-  return pos;
-}
-
 void UnloadGameTextures() {
   // Unload textures
   TraceLog(LOG_DEBUG, "Unloading textures");
@@ -92,72 +77,120 @@ void UnloadGameTextures() {
   }
 }
 
+struct InputFrame PollInputFrame() {
+  struct InputFrame frame = {
+      .mouseX = GetMouseX(),
+      .mouseY = GetMouseY(),
+  };
+
+  if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+    frame.buttons |= INPUT_LEFT_PRESSED;
+  if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON))
+    frame.buttons |= INPUT_LEFT_RELEASED;
+  if (IsMouseButtonDown(MOUSE_LEFT_BUTTON))
+    frame.buttons |= INPUT_LEFT_DOWN;
+
+  int key;
+  while (frame.keyCount < INPUT_MAX_KEYS && (key = GetKeyPressed()) != 0)
+    frame.keys[frame.keyCount++] = key;
+
+  return frame;
+}
+
 Texture2D *GetPieceTexture(const struct Piece *piece) {
   if (piece->player == WhitePlayer)
     return &(_whitePieceTextures[piece->type]);
   return &(_blackPieceTextures[piece->type]);
 }
 
-float clamp(float value, float min, float max) {
-  const float t = value < min ? min : value;
-  return t > max ? max : t;
+void DrawMoveArrow(struct Move move, float thickness, Color color) {
+  Vector2 from = {SQUARE_X(move.from) * SQUARE_SIZE + SQUARE_SIZE / 2.0f,
+                  SQUARE_Y(move.from) * SQUARE_SIZE + SQUARE_SIZE / 2.0f};
+  Vector2 to = {SQUARE_X(move.to) * SQUARE_SIZE + SQUARE_SIZE / 2.0f,
+                SQUARE_Y(move.to) * SQUARE_SIZE + SQUARE_SIZE / 2.0f};
+  float dx = to.x - from.x, dy = to.y - from.y;
+  float length = sqrtf(dx * dx + dy * dy);
+  if (length == 0)
+    return;
+
+  // Arrow head, listed counter-clockwise as DrawTriangle expects
+  Vector2 dir = {dx / length, dy / length};
+  Vector2 perp = {dir.y, -dir.x};
+  float head = thickness * 3;
+  Vector2 base = {to.x - dir.x * head, to.y - dir.y * head};
+  Vector2 wing = {perp.x * head / 2, perp.y * head / 2};
+  DrawLineEx(from, base, thickness, color);
+  DrawTriangle(to, (Vector2){base.x + wing.x, base.y + wing.y},
+               (Vector2){base.x - wing.x, base.y - wing.y}, color);
 }
 
-void update() {
-  if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-    TraceLog(LOG_DEBUG, "Left mouse button pressed");
-    Vector2 square = GetSquareOverlabByTheCursor();
-    selected = GetPieceInXYPosition(game, square.x, square.y);
-    if (selected != NULL) {
-      if (selected->player == GetCurrentPlayer(game)) {
-        selected->pos = GetMousePosition();
-        TraceLog(LOG_DEBUG, "piece on square %d-%d was selected",
-                 (int)selected->square.x, (int)selected->square.y);
-      } else {
-        TraceLog(LOG_DEBUG, "Can't move other player's piece");
-        selected = NULL;
-      }
-    } else {
-      TraceLog(LOG_DEBUG, "No piece on the square %d-%d", (int)square.x,
-               (int)square.y);
-    }
+// Renders the latest analysis snapshot without waiting for the search
+void DrawAnalysis() {
+  const struct AnalysisSnapshot *snapshot = GetAnalysisSnapshot(analysis);
+  if (snapshot->positionHash != GetPositionHash(game) ||
+      snapshot->lineCount == 0)
+    return;
+
+  // Worst line first so the best arrow ends up on top
+  for (int i = snapshot->lineCount - 1; i >= 0; i--) {
+    float thickness = i == 0 ? 8.0f : 5.0f;
+    DrawMoveArrow(snapshot->lines[i].pv[0], thickness,
+                  Fade(AnalysisArrow, i == 0 ? 1.0f : 0.5f));
   }
-  if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
-    TraceLog(LOG_DEBUG, "Left mouse button released");
-    bool couldMove = false;
-    if (selected != NULL) {
-      Vector2 newSquare = GetSquareOverlabByTheCursor();
-      TraceLog(LOG_DEBUG, "next square %f-%f", newSquare.x, newSquare.y);
-
-      if (MovePiece(game, &selected->square, &newSquare)) {
-        TraceLog(LOG_DEBUG, "piece was released at %f-%f", selected->square.x,
-                 selected->square.y);
-        NextPlayer(game);
-        couldMove = true;
-      } else {
-        TraceLog(LOG_DEBUG, "Can't move piece");
-      }
-      if (!couldMove) {
-        TraceLog(LOG_DEBUG, "piece was released at it origial square %f-%f",
-                 selected->square.x, selected->square.y);
 
-        selected->pos.x = selected->square.x * SQUARE_SIZE;
-        selected->pos.y = selected->square.y * SQUARE_SIZE;
-      }
-      selected = NULL;
-    }
+  int score = snapshot->lines[0].score;
+  int whiteScore = snapshot->sideToMove == WhitePlayer ? score : -score;
+  float whiteShare = 1.0f / (1.0f + powf(10.0f, -whiteScore / 400.0f));
+  int whiteHeight = (int)(whiteShare * WINDOW_HEIGHT);
+  DrawRectangle(0, 0, 10, WINDOW_HEIGHT - whiteHeight, BLACK);
+  DrawRectangle(0, WINDOW_HEIGHT - whiteHeight, 10, whiteHeight, WHITE);
+  DrawRectangleLines(0, 0, 10, WINDOW_HEIGHT, DARKGRAY);
+
+  const char *label =
+      TextFormat("depth %d  %+.2f", snapshot->depth, whiteScore / 100.0f);
+  if (abs(whiteScore) > MATE_BOUND) {
+    // Mate scores count plies up to the king capture that ends the line, so
+    // the mating side's moves are half of those before it: #+3 is white
+    // mating in three, #-2 black mating in two
+    int moves = (MATE_SCORE - abs(whiteScore) - 1) / 2;
+    label = TextFormat("depth %d  #%+d", snapshot->depth,
+                       whiteScore > 0 ? moves : -moves);
   }
+  DrawRectangle(14, 4, MeasureText(label, 16) + 8, 20, Fade(WHITE, 0.8f));
+  DrawText(label, 18, 6, 16, DARKGRAY);
+}
 
-  if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
-    if (selected != NULL) {
-      Vector2 mousePos = GetMousePosition();
-      mousePos.x =
-          clamp(mousePos.x, 0, WINDOW_WIDTH) - (float)PIECE_IMG_SIZE / 2;
-      mousePos.y =
-          clamp(mousePos.y, 0, WINDOW_WIDTH) - (float)PIECE_IMG_SIZE / 2;
-
-      selected->pos = mousePos;
-    }
+// Lists the most played moves of the position with a white/draw/black bar
+// per move. The query reads the mapped database directly, well under a
+// frame's budget.
+void DrawExplorer() {
+  struct ExplorerMove moves[EXPLORER_PANEL_MOVES];
+  unsigned count = QueryExplorer(explorer, GetPositionHash(game), moves,
+                                 EXPLORER_PANEL_MOVES);
+  if (count > EXPLORER_PANEL_MOVES)
+    count = EXPLORER_PANEL_MOVES;
+
+  int width = 230, rowHeight = 20;
+  int x = WINDOW_WIDTH - width - 4, y = 4;
+  DrawRectangle(x, y, width, rowHeight * (count + 1) + 8, Fade(WHITE, 0.85f));
+  DrawText(count == 0 ? "No games" : "Games", x + 6, y + 4, 16, DARKGRAY);
+
+  for (unsigned i = 0; i < count; i++) {
+    char san[8];
+    uint32_t games = moves[i].white + moves[i].draws + moves[i].black;
+    int rowY = y + rowHeight * (i + 1) + 4;
+    FormatSAN(game, moves[i].move, san, sizeof(san));
+    DrawText(san, x + 6, rowY, 16, DARKGRAY);
+    DrawText(TextFormat("%u", games), x + 60, rowY, 16, DARKGRAY);
+
+    int barX = x + 120, barWidth = width - 126;
+    int whiteWidth = (int)((uint64_t)barWidth * moves[i].white / games);
+    int drawWidth = (int)((uint64_t)barWidth * moves[i].draws / games);
+    DrawRectangle(barX, rowY, whiteWidth, 14, ExplorerWhiteWins);
+    DrawRectangle(barX + whiteWidth, rowY, drawWidth, 14, ExplorerDraws);
+    DrawRectangle(barX + whiteWidth + drawWidth, rowY,
+                  barWidth - whiteWidth - drawWidth, 14, ExplorerBlackWins);
+    DrawRectangleLines(barX, rowY, barWidth, 14, DARKGRAY);
   }
 }
 
@@ -178,6 +211,18 @@ void draw() {
     }
   }
 
+  // Highlight the cached possible targets of the piece being dragged
+  if (selected != NULL) {
+    uint64_t targets = GetPossibleTargets(game, &selected->square);
+    for (int square = 0; square < BOARD_SIZE * BOARD_SIZE; square++) {
+      if ((targets >> square) & 1) {
+        DrawRectangle(SQUARE_X(square) * SQUARE_SIZE,
+                      SQUARE_Y(square) * SQUARE_SIZE, SQUARE_SIZE, SQUARE_SIZE,
+                      PossibleTargetHighlight);
+      }
+    }
+  }
+
   for (int y = 0; y < BOARD_SIZE; y++) {
     for (int x = 0; x < BOARD_SIZE; x++) {
       // Get the piece in this position and draw it
@@ -196,15 +241,34 @@ void draw() {
                 selected->pos.y + padding, WHITE);
   }
 
+  if (analysis != NULL)
+    DrawAnalysis();
+  if (explorer != NULL && showExplorer)
+    DrawExplorer();
+
   EndDrawing();
 }
 
-int main() {
+// Usage: ./game [--record file] [--explorer db]
+int main(int argc, char **argv) {
+  struct InputRecorder recorder = {0};
+  struct Explorer openings;
 
 #ifdef DEBUG_MODE
-  SetTraceLogLevel(LOG_DEBUG);
+  SetAppTraceLogLevel(LOG_DEBUG);
 #endif
 
+  // Opened before LoadGameTextures changes the working directory
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--record") == 0)
+      OpenInputRecorder(&recorder, argv[i + 1]);
+    else if (strcmp(argv[i], "--explorer") == 0 &&
+             OpenExplorer(&openings, argv[i + 1])) {
+      explorer = &openings;
+      showExplorer = true;
+    }
+  }
+
   InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Chess");
   SetTargetFPS(60);
 
@@ -212,10 +276,16 @@ int main() {
   LoadGameTextures();
 
   while (!WindowShouldClose()) {
-    update();
+    struct InputFrame input = PollInputFrame();
+    RecordInputFrame(&recorder, &input);
+    update(&input);
     draw();
   }
 
+  CloseInputRecorder(&recorder, GetPositionHash(game));
+  DeleteAnalysis(analysis);
+  if (explorer != NULL)
+    CloseExplorer(explorer);
   CloseWindow();
 
   DeleteGame(game);
@@ -0,0 +1,302 @@
+#include "mate.h"
+#include "search.h"
+#include "see.h"
+
+#include <string.h>
+
+#define MATE_INFINITY (1u << 30)
+
+// Proof-number searches every node for a fixed number of remaining plies,
+// so a position is stored once per depth: a mate found with three plies to
+// spare says nothing about the same position with one
+#define REMAINING_KEY(remaining)                                               \
+  ((uint64_t)((remaining) + 1) * 0x9E3779B97F4A7C15ULL)
+
+struct MateSolver {
+  struct Game *game;
+  struct MateTable *table;
+  long long nodes;
+  long long maxNodes;
+  bool stopped;
+};
+
+bool NewMateTable(struct MateTable *table, size_t megabytes) {
+  // Entries come in pairs, so two is the smallest table
+  size_t count = 2;
+  while (count * 2 * sizeof(struct MateEntry) <= megabytes * 1024 * 1024)
+    count *= 2;
+
+  TraceLog(LOG_DEBUG, "Allocating mate table with %zu entries", count);
+  table->entries =
+      (struct MateEntry *)calloc(count, sizeof(struct MateEntry));
+  if (table->entries == NULL) {
+    TraceLog(LOG_ERROR, "Failed to allocate memory for mate table");
+    table->mask = 0;
+    return false;
+  }
+  table->mask = count - 1;
+  return true;
+}
+
+void DeleteMateTable(struct MateTable *table) {
+  if (table == NULL)
+    return;
+  free(table->entries);
+  table->entries = NULL;
+  table->mask = 0;
+}
+
+void ClearMateTable(struct MateTable *table) {
+  if (table != NULL && table->entries != NULL)
+    memset(table->entries, 0, (table->mask + 1) * sizeof(struct MateEntry));
+}
+
+static struct MateEntry *probeMate(const struct MateTable *table,
+                                   uint64_t key) {
+  struct MateEntry *bucket = &table->entries[key & table->mask & ~(size_t)1];
+  if (bucket[0].key == key)
+    return &bucket[0];
+  if (bucket[1].key == key)
+    return &bucket[1];
+  return NULL;
+}
+
+// Two-way buckets: a key overwrites its own entry, otherwise an empty slot
+// or the entry that took less work to compute makes way
+static void storeMate(struct MateTable *table, const struct MateEntry *entry) {
+  struct MateEntry *bucket =
+      &table->entries[entry->key & table->mask & ~(size_t)1];
+  struct MateEntry *slot = &bucket[0];
+  if (bucket[1].key == entry->key)
+    slot = &bucket[1];
+  else if (bucket[0].key != entry->key && bucket[0].key != 0 &&
+           (bucket[1].key == 0 || bucket[1].work < bucket[0].work))
+    slot = &bucket[1];
+  *slot = *entry;
+}
+
+// Pseudo-legal moves from the move picker that do not leave the mover's
+// king attacked, with the table keys of the positions they lead to and
+// whether they give check
+static unsigned legalMoves(struct Game *game, int remaining,
+                           struct Move *moves, uint64_t *keys, bool *checks) {
+  enum Player player = GetCurrentPlayer(game);
+  enum Player opponent = player == WhitePlayer ? BlackPlayer : WhitePlayer;
+  struct MovePicker picker;
+  struct Move move;
+  struct Undo undo;
+  unsigned count = 0;
+
+  InitPlainMovePicker(&picker, game);
+  while (NextMove(&picker, &move)) {
+    MakeMove(game, move, &undo);
+    if (!IsInCheck(game, player)) {
+      moves[count] = move;
+      keys[count] = GetPositionHash(game) ^ REMAINING_KEY(remaining - 1);
+      checks[count] = IsInCheck(game, opponent);
+      count++;
+    }
+    UnmakeMove(game, &undo);
+  }
+  return count;
+}
+
+static uint32_t saturatingAdd(uint32_t a, uint32_t b) {
+  if (a >= MATE_INFINITY || b >= MATE_INFINITY)
+    return MATE_INFINITY;
+  return a + b < MATE_INFINITY - 1 ? a + b : MATE_INFINITY - 1;
+}
+
+// Depth-first proof-number search (df-pn) in the phi/delta form: phi is the
+// proof number at nodes where the mating side moves and the disproof number
+// elsewhere, so both node types minimise phi over their children. The node
+// is expanded until phi or delta reaches its threshold, then its numbers
+// are stored and `out` receives them.
+static void searchMate(struct MateSolver *s, uint64_t key, int remaining,
+                       bool attacking, uint32_t thPhi, uint32_t thDelta,
+                       struct MateEntry *out) {
+  struct Game *game = s->game;
+  long long startNodes = s->nodes++;
+  if (s->maxNodes > 0 && s->nodes >= s->maxNodes)
+    s->stopped = true;
+
+  *out = (struct MateEntry){.key = key, .move = NULL_MOVE};
+
+  // With no plies left only a mate already on the board counts
+  bool inCheck = IsInCheck(game, GetCurrentPlayer(game));
+  if (remaining == 0 && !(inCheck && !attacking)) {
+    out->proof = MATE_INFINITY;
+    storeMate(s->table, out);
+    return;
+  }
+
+  struct Move moves[MAX_MOVES];
+  uint64_t keys[MAX_MOVES];
+  bool checks[MAX_MOVES];
+  unsigned count = legalMoves(game, remaining, moves, keys, checks);
+  if (count == 0 || remaining == 0) {
+    // Checkmate proves the mate; stalemate, a mating side with no moves or
+    // a check that can be answered at the horizon disprove it
+    if (count == 0 && inCheck && !attacking)
+      out->disproof = MATE_INFINITY;
+    else
+      out->proof = MATE_INFINITY;
+    storeMate(s->table, out);
+    return;
+  }
+
+  // Children's numbers are kept here as well as in the table, so a sibling
+  // evicting an entry costs a search again rather than an endless loop.
+  // Unknown children start out favouring checks; on the last ply nothing
+  // else can mate.
+  struct MateEntry children[MAX_MOVES];
+  for (unsigned i = 0; i < count; i++) {
+    const struct MateEntry *entry = probeMate(s->table, keys[i]);
+    children[i] = (struct MateEntry){.key = keys[i], .proof = 1,
+                                     .disproof = 1};
+    if (entry != NULL) {
+      children[i] = *entry;
+    } else if (attacking && !checks[i] && remaining == 1) {
+      children[i].proof = MATE_INFINITY;
+      children[i].disproof = 0;
+    } else if (attacking && !checks[i]) {
+      children[i].proof = 2;
+    }
+  }
+
+  uint32_t phi = 0, delta = 0;
+  for (;;) {
+    uint32_t delta2 = MATE_INFINITY;
+    unsigned best = 0;
+    phi = MATE_INFINITY;
+    delta = 0;
+    for (unsigned i = 0; i < count; i++) {
+      uint32_t childPhi =
+          attacking ? children[i].disproof : children[i].proof;
+      uint32_t childDelta =
+          attacking ? children[i].proof : children[i].disproof;
+
+      delta = saturatingAdd(delta, childPhi);
+      if (childDelta < phi) {
+        delta2 = phi;
+        phi = childDelta;
+        best = i;
+      } else if (childDelta < delta2) {
+        delta2 = childDelta;
+      }
+    }
+
+    if (phi >= thPhi || delta >= thDelta || s->stopped)
+      break;
+
+    uint32_t bestPhi =
+        attacking ? children[best].disproof : children[best].proof;
+    uint64_t childThPhi = (uint64_t)thDelta + bestPhi - delta;
+    if (childThPhi > MATE_INFINITY)
+      childThPhi = MATE_INFINITY;
+    uint32_t childThDelta = delta2 + 1 < thPhi ? delta2 + 1 : thPhi;
+
+    struct Undo undo;
+    MakeMove(game, moves[best], &undo);
+    searchMate(s, keys[best], remaining - 1, !attacking,
+               (uint32_t)childThPhi, childThDelta, &children[best]);
+    UnmakeMove(game, &undo);
+  }
+
+  out->proof = attacking ? phi : delta;
+  out->disproof = attacking ? delta : phi;
+  long long work = s->nodes - startNodes;
+  out->work = work < UINT32_MAX ? (uint32_t)work : UINT32_MAX;
+
+  // Remember the quickest proven mate, or for the defence the slowest
+  if (out->proof == 0) {
+    int plies = attacking ? remaining : 0;
+    for (unsigned i = 0; i < count; i++) {
+      if (children[i].proof != 0)
+        continue;
+      int childPlies = children[i].plies + 1;
+      if (attacking ? childPlies <= plies : childPlies > plies) {
+        plies = childPlies;
+        out->move = moves[i];
+      }
+    }
+    out->plies = (uint8_t)plies;
+  }
+  storeMate(s->table, out);
+}
+
+// Walks the proof from the root: the mating side plays its quickest mate
+// and the defence its slowest. Entries lost to replacement are proven again.
+static void extractLine(struct MateSolver *s, int remaining,
+                        struct MateResult *result) {
+  struct Game *game = s->game;
+  struct Undo undo[MATE_MAX_LINE];
+  s->maxNodes = 0;
+  s->stopped = false;
+
+  while (remaining > 0 && result->lineLength < MATE_MAX_LINE) {
+    bool attacking = result->lineLength % 2 == 0;
+    uint64_t key = GetPositionHash(game) ^ REMAINING_KEY(remaining);
+    const struct MateEntry *entry = probeMate(s->table, key);
+    struct MateEntry node;
+    if (entry == NULL || entry->proof != 0 || IS_NULL_MOVE(entry->move)) {
+      searchMate(s, key, remaining, attacking, MATE_INFINITY, MATE_INFINITY,
+                 &node);
+      entry = &node;
+    }
+    if (entry->proof != 0 || IS_NULL_MOVE(entry->move))
+      break;
+
+    struct Move move = entry->move;
+    MakeMove(game, move, &undo[result->lineLength]);
+    result->line[result->lineLength++] = move;
+    remaining--;
+  }
+
+  for (int i = result->lineLength - 1; i >= 0; i--)
+    UnmakeMove(game, &undo[i]);
+}
+
+struct MateResult SolveMate(struct Game *game, struct MateTable *table,
+                            int maxMoves, long long maxNodes) {
+  struct MateSolver solver = {
+      .game = game, .table = table, .maxNodes = maxNodes};
+  struct MateResult result = {.outcome = MateUnresolved};
+  long long startMs = GetMonotonicTimeMs();
+
+  enum Player defender =
+      GetCurrentPlayer(game) == WhitePlayer ? BlackPlayer : WhitePlayer;
+  if (IsInCheck(game, defender)) {
+    result.outcome = MateIllegal;
+    return result;
+  }
+  if (maxMoves > MATE_MAX_MOVES)
+    maxMoves = MATE_MAX_MOVES;
+
+  // Deepening one move at a time makes the first proof the shortest mate;
+  // entries from shallower passes stay valid as they are keyed by depth
+  for (int moves = 1; moves <= maxMoves && !solver.stopped; moves++) {
+    int remaining = 2 * moves - 1;
+    uint64_t key = GetPositionHash(game) ^ REMAINING_KEY(remaining);
+    struct MateEntry root;
+    searchMate(&solver, key, remaining, true, MATE_INFINITY, MATE_INFINITY,
+               &root);
+
+    if (root.proof == 0) {
+      result.outcome = MateProven;
+      result.moves = moves;
+      result.nodes = solver.nodes;
+      extractLine(&solver, remaining, &result);
+      break;
+    }
+    if (root.disproof == 0 && moves == maxMoves) {
+      result.outcome = MateDisproven;
+      result.moves = maxMoves;
+    }
+  }
+
+  if (result.outcome != MateProven)
+    result.nodes = solver.nodes;
+  result.timeMs = GetMonotonicTimeMs() - startMs;
+  return result;
+}
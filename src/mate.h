@@ -0,0 +1,59 @@
+#ifndef MATE_H
+#define MATE_H
+
+#include "game.h"
+#include "movepick.h"
+
+// Longest problem the solver accepts, in moves of the side to mate
+#define MATE_MAX_MOVES 16
+#define MATE_MAX_LINE (2 * MATE_MAX_MOVES - 1)
+
+// Proof and disproof numbers are counted from the point of view of the side
+// trying to mate, whichever side is to move at the entry
+struct MateEntry {
+  uint64_t key;
+  uint32_t proof;
+  uint32_t disproof;
+  // Nodes spent below this entry; the cheaper of two entries is replaced
+  uint32_t work;
+  struct Move move;
+  // Plies to mate once proven
+  uint8_t plies;
+};
+
+struct MateTable {
+  struct MateEntry *entries;
+  size_t mask;
+};
+
+enum MateOutcome {
+  // The node limit ran out first
+  MateUnresolved = 0,
+  MateProven,
+  MateDisproven,
+  // The side not to move is in check, so the position cannot arise
+  MateIllegal,
+};
+
+struct MateResult {
+  enum MateOutcome outcome;
+  // Length of the shortest mate when proven, the limit when disproven
+  int moves;
+  struct Move line[MATE_MAX_LINE];
+  int lineLength;
+  long long nodes;
+  long long timeMs;
+};
+
+bool NewMateTable(struct MateTable *table, size_t megabytes);
+void DeleteMateTable(struct MateTable *table);
+void ClearMateTable(struct MateTable *table);
+
+// Looks for a mate by the side to move in at most `maxMoves` moves with
+// depth-first proof-number search. A `maxNodes` of zero means no limit. The
+// game is returned in the position it was given. Positions where the side
+// not to move is in check are rejected without searching.
+struct MateResult SolveMate(struct Game *game, struct MateTable *table,
+                            int maxMoves, long long maxNodes);
+
+#endif // MATE_H
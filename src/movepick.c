@@ -0,0 +1,303 @@
+#include "movepick.h"
+#include "see.h"
+
+#include <string.h>
+
+bool IsCaptureMove(const struct Game *game, struct Move move) {
+  return game->board->pieces[SQUARE_X(move.to)][SQUARE_Y(move.to)] != NULL;
+}
+
+// Checks that a move taken from a table (hash, killer or countermove) is
+// still playable by the side to move in the current position
+bool IsPseudoLegalMove(const struct Game *game, struct Move move) {
+  if (IS_NULL_MOVE(move) || move.from >= 64 || move.to >= 64)
+    return false;
+
+  const struct Piece *piece =
+      game->board->pieces[SQUARE_X(move.from)][SQUARE_Y(move.from)];
+  if (piece == NULL || piece->player != GetCurrentPlayer(game))
+    return false;
+
+  const struct Piece *target =
+      game->board->pieces[SQUARE_X(move.to)][SQUARE_Y(move.to)];
+  if (target != NULL && target->player == piece->player)
+    return false;
+
+  struct Moves moves = GetPossibleMoves(game, &piece->square);
+  for (unsigned i = 0; i < moves.size; i++) {
+    if ((int)moves.squares[i].x == SQUARE_X(move.to) &&
+        (int)moves.squares[i].y == SQUARE_Y(move.to))
+      return true;
+  }
+  return false;
+}
+
+// Which moves a generation pass collects
+enum GenerationKind {
+  GenerateCaptures,
+  GenerateQuiets,
+  // Every move, into the quiet list in generation order
+  GenerateAll,
+};
+
+// Walks every piece of the side to move through GetPossibleMoves. Captures
+// and quiets are generated in separate passes, so a cutoff before the quiet
+// stage never pays for quiet moves.
+static void generateMoves(struct MovePicker *picker,
+                          enum GenerationKind kind) {
+  const struct Game *game = picker->game;
+  enum Player player = GetCurrentPlayer(game);
+
+  if (kind == GenerateCaptures)
+    picker->captureCount = picker->captureIndex = 0;
+  else
+    picker->quietCount = picker->quietIndex = 0;
+
+  for (int x = 0; x < 8; x++) {
+    for (int y = 0; y < 8; y++) {
+      const struct Piece *piece = game->board->pieces[x][y];
+      if (piece == NULL || piece->player != player)
+        continue;
+
+      struct Moves moves = GetPossibleMoves(game, &piece->square);
+      for (unsigned i = 0; i < moves.size; i++) {
+        int toX = moves.squares[i].x;
+        int toY = moves.squares[i].y;
+        struct Move move = {SQUARE_INDEX(x, y), SQUARE_INDEX(toX, toY)};
+        const struct Piece *target = game->board->pieces[toX][toY];
+
+        if (kind == GenerateCaptures && target != NULL) {
+          picker->captureScores[picker->captureCount] =
+              SeeValue[target->type] * 16 - SeeValue[piece->type] / 100;
+          picker->captures[picker->captureCount++] = move;
+        } else if (kind == GenerateAll ||
+                   (kind == GenerateQuiets && target == NULL)) {
+          picker->quiets[picker->quietCount++] = move;
+        }
+      }
+    }
+  }
+}
+
+// Selection sort step: swaps the best remaining entry to `index` and
+// returns it, so moves after a cutoff are never sorted
+static struct Move pickBest(struct Move *moves, int *scores, unsigned index,
+                            unsigned count) {
+  unsigned best = index;
+  for (unsigned i = index + 1; i < count; i++) {
+    if (scores[i] > scores[best])
+      best = i;
+  }
+
+  struct Move move = moves[best];
+  int score = scores[best];
+  moves[best] = moves[index];
+  scores[best] = scores[index];
+  moves[index] = move;
+  scores[index] = score;
+  return move;
+}
+
+static bool isGoodCapture(const struct Game *game, struct Move move) {
+  const struct Piece *attacker =
+      game->board->pieces[SQUARE_X(move.from)][SQUARE_Y(move.from)];
+  const struct Piece *victim =
+      game->board->pieces[SQUARE_X(move.to)][SQUARE_Y(move.to)];
+
+  // Taking something at least as valuable can never lose material
+  if (SeeValue[victim->type] >= SeeValue[attacker->type])
+    return true;
+  return SeeAtLeast(game, move, 0);
+}
+
+static bool isTableQuiet(const struct MovePicker *picker, struct Move move) {
+  return !IS_NULL_MOVE(move) && !SAME_MOVE(move, picker->hashMove) &&
+         IsPseudoLegalMove(picker->game, move) &&
+         !IsCaptureMove(picker->game, move);
+}
+
+static bool isAlreadyTried(const struct MovePicker *picker, struct Move move) {
+  return SAME_MOVE(move, picker->hashMove) ||
+         SAME_MOVE(move, picker->killers[0]) ||
+         SAME_MOVE(move, picker->killers[1]) ||
+         SAME_MOVE(move, picker->counterMove);
+}
+
+void InitMovePicker(struct MovePicker *picker, const struct Game *game,
+                    struct Move hashMove,
+                    const struct SearchHeuristics *heuristics, int ply,
+                    struct Move previous) {
+  picker->game = game;
+  picker->heuristics = heuristics;
+  picker->stage = StageHashMove;
+  picker->hashMove = hashMove;
+  picker->killers[0] = picker->killers[1] = NULL_MOVE;
+  picker->counterMove = NULL_MOVE;
+  picker->badCaptureCount = picker->badCaptureIndex = 0;
+
+  if (heuristics != NULL) {
+    if (ply < MAX_PLY) {
+      picker->killers[0] = heuristics->killers[ply][0];
+      picker->killers[1] = heuristics->killers[ply][1];
+    }
+    if (!IS_NULL_MOVE(previous))
+      picker->counterMove =
+          heuristics->counterMoves[previous.from][previous.to];
+  }
+}
+
+// Good captures only, for quiescence search
+void InitCapturePicker(struct MovePicker *picker, const struct Game *game) {
+  InitMovePicker(picker, game, NULL_MOVE, NULL, 0, NULL_MOVE);
+  picker->stage = StageCapturesOnly;
+  generateMoves(picker, GenerateCaptures);
+}
+
+// Raw generation order with no ordering at all, the baseline the staged
+// picker is measured against
+void InitPlainMovePicker(struct MovePicker *picker,
+                         const struct Game *game) {
+  InitMovePicker(picker, game, NULL_MOVE, NULL, 0, NULL_MOVE);
+  picker->stage = StagePlain;
+  generateMoves(picker, GenerateAll);
+}
+
+bool NextMove(struct MovePicker *picker, struct Move *move) {
+  struct Move candidate;
+
+  switch (picker->stage) {
+  case StageHashMove:
+    picker->stage = StageGenerateCaptures;
+    if (IsPseudoLegalMove(picker->game, picker->hashMove)) {
+      *move = picker->hashMove;
+      return true;
+    }
+    // fall through
+  case StageGenerateCaptures:
+    generateMoves(picker, GenerateCaptures);
+    picker->stage = StageGoodCaptures;
+    // fall through
+  case StageGoodCaptures:
+    while (picker->captureIndex < picker->captureCount) {
+      candidate = pickBest(picker->captures, picker->captureScores,
+                           picker->captureIndex++, picker->captureCount);
+      if (SAME_MOVE(candidate, picker->hashMove))
+        continue;
+      if (!isGoodCapture(picker->game, candidate)) {
+        picker->badCaptures[picker->badCaptureCount++] = candidate;
+        continue;
+      }
+      *move = candidate;
+      return true;
+    }
+    picker->stage = StageKiller1;
+    // fall through
+  case StageKiller1:
+    picker->stage = StageKiller2;
+    if (isTableQuiet(picker, picker->killers[0])) {
+      *move = picker->killers[0];
+      return true;
+    }
+    // fall through
+  case StageKiller2:
+    picker->stage = StageCounterMove;
+    if (!SAME_MOVE(picker->killers[1], picker->killers[0]) &&
+        isTableQuiet(picker, picker->killers[1])) {
+      *move = picker->killers[1];
+      return true;
+    }
+    // fall through
+  case StageCounterMove:
+    picker->stage = StageGenerateQuiets;
+    if (!SAME_MOVE(picker->counterMove, picker->killers[0]) &&
+        !SAME_MOVE(picker->counterMove, picker->killers[1]) &&
+        isTableQuiet(picker, picker->counterMove)) {
+      *move = picker->counterMove;
+      return true;
+    }
+    // fall through
+  case StageGenerateQuiets: {
+    enum Player player = GetCurrentPlayer(picker->game);
+    generateMoves(picker, GenerateQuiets);
+    for (unsigned i = 0; i < picker->quietCount; i++) {
+      struct Move quiet = picker->quiets[i];
+      picker->quietScores[i] =
+          picker->heuristics != NULL
+              ? picker->heuristics->history[player][quiet.from][quiet.to]
+              : 0;
+    }
+    picker->stage = StageQuiets;
+  }
+    // fall through
+  case StageQuiets:
+    while (picker->quietIndex < picker->quietCount) {
+      candidate = pickBest(picker->quiets, picker->quietScores,
+                           picker->quietIndex++, picker->quietCount);
+      if (isAlreadyTried(picker, candidate))
+        continue;
+      *move = candidate;
+      return true;
+    }
+    picker->stage = StageBadCaptures;
+    // fall through
+  case StageBadCaptures:
+    if (picker->badCaptureIndex < picker->badCaptureCount) {
+      *move = picker->badCaptures[picker->badCaptureIndex++];
+      return true;
+    }
+    picker->stage = StageDone;
+    return false;
+
+  case StageCapturesOnly:
+    while (picker->captureIndex < picker->captureCount) {
+      candidate = pickBest(picker->captures, picker->captureScores,
+                           picker->captureIndex++, picker->captureCount);
+      if (!isGoodCapture(picker->game, candidate))
+        continue;
+      *move = candidate;
+      return true;
+    }
+    picker->stage = StageDone;
+    return false;
+
+  case StagePlain:
+    if (picker->quietIndex < picker->quietCount) {
+      *move = picker->quiets[picker->quietIndex++];
+      return true;
+    }
+    picker->stage = StageDone;
+    return false;
+
+  case StageDone:
+  default:
+    return false;
+  }
+}
+
+void ClearSearchHeuristics(struct SearchHeuristics *heuristics) {
+  memset(heuristics, 0, sizeof(*heuristics));
+}
+
+// Called when a quiet move causes a beta cutoff
+void UpdateQuietHeuristics(struct SearchHeuristics *heuristics,
+                           enum Player player, struct Move move,
+                           struct Move previous, int ply, int depth) {
+  if (ply < MAX_PLY && !SAME_MOVE(heuristics->killers[ply][0], move)) {
+    heuristics->killers[ply][1] = heuristics->killers[ply][0];
+    heuristics->killers[ply][0] = move;
+  }
+
+  if (!IS_NULL_MOVE(previous))
+    heuristics->counterMoves[previous.from][previous.to] = move;
+
+  int *entry = &heuristics->history[player][move.from][move.to];
+  *entry += depth * depth;
+  if (*entry > HISTORY_MAX) {
+    // Age the whole table so recent cutoffs keep dominating
+    for (int from = 0; from < 64; from++) {
+      for (int to = 0; to < 64; to++) {
+        heuristics->history[player][from][to] /= 2;
+      }
+    }
+  }
+}
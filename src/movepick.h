@@ -0,0 +1,69 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include "game.h"
+
+#define MAX_MOVES 256
+#define MAX_PLY 64
+#define HISTORY_MAX 16384
+
+// Quiet-move ordering state shared by every node of a search
+struct SearchHeuristics {
+  struct Move killers[MAX_PLY][2];
+  struct Move counterMoves[64][64];
+  int history[2][64][64];
+};
+
+enum MovePickerStage {
+  StageHashMove = 0,
+  StageGenerateCaptures,
+  StageGoodCaptures,
+  StageKiller1,
+  StageKiller2,
+  StageCounterMove,
+  StageGenerateQuiets,
+  StageQuiets,
+  StageBadCaptures,
+  StageCapturesOnly,
+  StagePlain,
+  StageDone,
+};
+
+struct MovePicker {
+  const struct Game *game;
+  const struct SearchHeuristics *heuristics;
+  enum MovePickerStage stage;
+
+  struct Move hashMove;
+  struct Move killers[2];
+  struct Move counterMove;
+
+  struct Move captures[MAX_MOVES];
+  int captureScores[MAX_MOVES];
+  unsigned captureCount, captureIndex;
+
+  struct Move badCaptures[MAX_MOVES];
+  unsigned badCaptureCount, badCaptureIndex;
+
+  struct Move quiets[MAX_MOVES];
+  int quietScores[MAX_MOVES];
+  unsigned quietCount, quietIndex;
+};
+
+void InitMovePicker(struct MovePicker *picker, const struct Game *game,
+                    struct Move hashMove,
+                    const struct SearchHeuristics *heuristics, int ply,
+                    struct Move previous);
+void InitCapturePicker(struct MovePicker *picker, const struct Game *game);
+void InitPlainMovePicker(struct MovePicker *picker,
+                         const struct Game *game);
+bool NextMove(struct MovePicker *picker, struct Move *move);
+
+bool IsPseudoLegalMove(const struct Game *game, struct Move move);
+bool IsCaptureMove(const struct Game *game, struct Move move);
+void ClearSearchHeuristics(struct SearchHeuristics *heuristics);
+void UpdateQuietHeuristics(struct SearchHeuristics *heuristics,
+                           enum Player player, struct Move move,
+                           struct Move previous, int ply, int depth);
+
+#endif // MOVEPICK_H
@@ -0,0 +1,61 @@
+// Fixed-depth node counts with and without move ordering over the benchmark
+// positions. Usage: ./nodes [depth]
+
+#include "positions.h"
+#include "search.h"
+
+#define DEFAULT_DEPTH 4
+#define TT_SIZE_MB 16
+
+static long long searchNodes(struct Search *search, int depth,
+                             bool orderMoves) {
+  ClearTranspositionTable(search->tt);
+  ClearSearchHeuristics(&search->heuristics);
+  search->orderMoves = orderMoves;
+
+  struct SearchLimits limits = {.depth = depth};
+  struct SearchResult result = SearchPosition(search, &limits);
+  return result.nodes;
+}
+
+int main(int argc, char **argv) {
+  int depth = argc > 1 ? atoi(argv[1]) : DEFAULT_DEPTH;
+  if (depth <= 0 || depth >= MAX_PLY) {
+    fprintf(stderr, "Invalid depth '%s'\n", argv[1]);
+    return 1;
+  }
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  struct Game *game = NewGame();
+  struct TranspositionTable tt;
+  struct Search *search = (struct Search *)malloc(sizeof(struct Search));
+  if (game == NULL || search == NULL ||
+      !NewTranspositionTable(&tt, TT_SIZE_MB)) {
+    fprintf(stderr, "Failed to allocate search state\n");
+    return 1;
+  }
+  InitSearch(search, game, &tt);
+
+  long long totalPlain = 0, totalOrdered = 0;
+  printf("%-4s %14s %14s %9s\n", "pos", "plain", "ordered", "saved");
+  for (unsigned i = 0; i < BenchmarkPositionCount; i++) {
+    if (!LoadFEN(game, BenchmarkPositions[i]))
+      return 1;
+
+    long long plain = searchNodes(search, depth, false);
+    long long ordered = searchNodes(search, depth, true);
+    totalPlain += plain;
+    totalOrdered += ordered;
+
+    printf("%-4u %14lld %14lld %8.1f%%\n", i, plain, ordered,
+           100.0 * (double)(plain - ordered) / (double)plain);
+  }
+  printf("%-4s %14lld %14lld %8.1f%%\n", "all", totalPlain, totalOrdered,
+         100.0 * (double)(totalPlain - totalOrdered) / (double)totalPlain);
+
+  DeleteTranspositionTable(&tt);
+  free(search);
+  DeleteGame(game);
+  return 0;
+}
@@ -0,0 +1,809 @@
+// Opening explorer database: builder, query tool and latency benchmark.
+//
+// Usage: ./openings build [--threads N] [--chunk-mb N] [--max-ply N]
+//                         --output db archive.pgn...
+//        ./openings query db [--fen FEN] [move...]
+//        ./openings bench db [--queries N]
+//
+// The builder replays every game through the board and records (position,
+// move, result) for each ply. Workers sort those records in bounded chunks
+// and spill them as sorted runs; the runs are then merged in parallel, each
+// thread owning a slice of the key space, into one immutable file that the
+// query tool and the GUI map directly. A game stops being indexed at its
+// first castling, en passant or promotion, which the board cannot play.
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "explorer.h"
+#include "pgn.h"
+#include "tools.h"
+
+#define MAX_SLICES 65536
+#define MAX_RUNS 4096
+#define SLICE_MIN_BYTES (4 << 20)
+#define INDEX_MAX_BITS 28
+#define COPY_BUFFER_BYTES (4 << 20)
+#define QUERY_MAX_MOVES 64
+
+struct Archive {
+  const char *path;
+  const char *text;
+  size_t length;
+};
+
+// A byte range of one archive that starts at a game boundary
+struct Slice {
+  const struct Archive *archive;
+  size_t begin;
+  size_t end;
+};
+
+struct Run {
+  char path[512];
+  const struct ExplorerEntry *entries;
+  size_t count;
+};
+
+struct Builder {
+  const char *output;
+  unsigned threads;
+  size_t chunkEntries;
+  unsigned maxPly;
+
+  struct Archive *archives;
+  unsigned archiveCount;
+  struct Slice slices[MAX_SLICES];
+  unsigned sliceCount;
+  atomic_uint nextSlice;
+
+  pthread_mutex_t lock;
+  struct Run runs[MAX_RUNS];
+  unsigned runCount;
+  bool failed;
+  unsigned long long games, skipped, truncated, records;
+
+  // Merge phase: partition p owns index buckets [p * B / P, (p + 1) * B / P)
+  unsigned indexBits;
+  unsigned partitions;
+  atomic_uint nextPartition;
+  uint64_t *index;
+  unsigned long long *segmentEntries;
+  unsigned long long *segmentPositions;
+};
+
+struct ParseWorker {
+  struct Builder *builder;
+  struct Game *game;
+  struct ExplorerEntry *chunk;
+  struct ExplorerEntry *scratch;
+  size_t *histogram;
+  size_t count;
+  unsigned long long games, skipped, truncated, records;
+};
+
+struct MergeCursor {
+  const struct ExplorerEntry *next;
+  const struct ExplorerEntry *end;
+};
+
+static uint64_t bucketOf(uint64_t key, unsigned bits) {
+  return bits == 0 ? 0 : key >> (64 - bits);
+}
+
+static bool entryLess(const struct ExplorerEntry *a,
+                      const struct ExplorerEntry *b) {
+  return a->key < b->key || (a->key == b->key && a->move < b->move);
+}
+
+static unsigned radixDigit(const struct ExplorerEntry *entry, int pass) {
+  if (pass == 0)
+    return entry->move;
+  return (unsigned)(entry->key >> (16 * (pass - 1))) & 0xFFFF;
+}
+
+// LSD radix sort on (key, move) in 16-bit digits: the move first, then the
+// key from its low digit up. Digits every record shares are skipped.
+static void radixSort(struct ExplorerEntry *entries,
+                      struct ExplorerEntry *scratch, size_t *histogram,
+                      size_t count) {
+  struct ExplorerEntry *src = entries, *dst = scratch;
+
+  for (int pass = 0; pass < 5 && count > 1; pass++) {
+    memset(histogram, 0, 65536 * sizeof(size_t));
+    for (size_t i = 0; i < count; i++)
+      histogram[radixDigit(&src[i], pass)]++;
+    if (histogram[radixDigit(&src[0], pass)] == count)
+      continue;
+
+    size_t sum = 0;
+    for (size_t d = 0; d < 65536; d++) {
+      size_t n = histogram[d];
+      histogram[d] = sum;
+      sum += n;
+    }
+    for (size_t i = 0; i < count; i++)
+      dst[histogram[radixDigit(&src[i], pass)]++] = src[i];
+
+    struct ExplorerEntry *swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  if (src != entries)
+    memcpy(entries, src, count * sizeof(*entries));
+}
+
+// Sums the counts of adjacent records for the same position and move
+static size_t aggregate(struct ExplorerEntry *entries, size_t count) {
+  size_t out = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (out > 0 && entries[out - 1].key == entries[i].key &&
+        entries[out - 1].move == entries[i].move) {
+      entries[out - 1].white += entries[i].white;
+      entries[out - 1].draws += entries[i].draws;
+      entries[out - 1].black += entries[i].black;
+    } else {
+      entries[out++] = entries[i];
+    }
+  }
+  return out;
+}
+
+static bool writeRun(struct ParseWorker *w) {
+  struct Builder *b = w->builder;
+  radixSort(w->chunk, w->scratch, w->histogram, w->count);
+  size_t count = aggregate(w->chunk, w->count);
+  w->count = 0;
+
+  pthread_mutex_lock(&b->lock);
+  unsigned id = b->runCount < MAX_RUNS ? b->runCount++ : MAX_RUNS;
+  pthread_mutex_unlock(&b->lock);
+  if (id == MAX_RUNS) {
+    fprintf(stderr, "Too many sorted runs, raise --chunk-mb\n");
+    return false;
+  }
+
+  struct Run *run = &b->runs[id];
+  snprintf(run->path, sizeof(run->path), "%s.run%u", b->output, id);
+  run->count = count;
+  FILE *file = fopen(run->path, "wb");
+  if (file == NULL ||
+      fwrite(w->chunk, sizeof(*w->chunk), count, file) != count) {
+    fprintf(stderr, "Failed to write sorted run '%s'\n", run->path);
+    if (file != NULL)
+      fclose(file);
+    return false;
+  }
+  return fclose(file) == 0;
+}
+
+static bool parseSlice(struct ParseWorker *w, const struct Slice *slice) {
+  const char *text = slice->archive->text + slice->begin;
+  size_t length = slice->end - slice->begin, offset = 0;
+  unsigned maxPly = w->builder->maxPly;
+  struct PgnGame pgn;
+  char token[32];
+
+  while (NextPgnGame(text, length, &offset, &pgn)) {
+    if (pgn.result == ResultUnknown ||
+        (pgn.fen[0] != '\0' && !LoadFEN(w->game, pgn.fen))) {
+      w->skipped++;
+      continue;
+    }
+    if (pgn.fen[0] == '\0')
+      ResetDefaultConfiguration(w->game);
+    w->games++;
+
+    const char *cursor = pgn.movetext, *end = cursor + pgn.movetextLength;
+    for (unsigned ply = 0; maxPly == 0 || ply < maxPly; ply++) {
+      struct Move move;
+      struct Undo undo;
+      if (!NextSanToken(&cursor, end, token, sizeof(token)))
+        break;
+      if (!ParseSAN(w->game, token, &move)) {
+        w->truncated++;
+        break;
+      }
+
+      if (w->count == w->builder->chunkEntries && !writeRun(w))
+        return false;
+      w->chunk[w->count++] = (struct ExplorerEntry){
+          .key = GetPositionHash(w->game),
+          .move = EXPLORER_MOVE(move.from, move.to),
+          .white = pgn.result == ResultWhiteWins,
+          .draws = pgn.result == ResultDraw,
+          .black = pgn.result == ResultBlackWins,
+      };
+      w->records++;
+      MakeMove(w->game, move, &undo);
+    }
+  }
+  return true;
+}
+
+static void *parseWorker(void *arg) {
+  struct ParseWorker *w = (struct ParseWorker *)arg;
+  struct Builder *b = w->builder;
+  bool ok = true;
+
+  unsigned i;
+  while (ok && (i = atomic_fetch_add(&b->nextSlice, 1)) < b->sliceCount)
+    ok = parseSlice(w, &b->slices[i]);
+  if (ok && w->count > 0)
+    ok = writeRun(w);
+
+  pthread_mutex_lock(&b->lock);
+  b->failed |= !ok;
+  b->games += w->games;
+  b->skipped += w->skipped;
+  b->truncated += w->truncated;
+  b->records += w->records;
+  pthread_mutex_unlock(&b->lock);
+  return NULL;
+}
+
+// First entry of a run whose key falls in `bucket` or later
+static size_t lowerBoundBucket(const struct Run *run, uint64_t bucket,
+                               unsigned bits) {
+  size_t lo = 0, hi = run->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (bucketOf(run->entries[mid].key, bits) < bucket)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static void siftDown(struct MergeCursor *cursors, unsigned *heap,
+                     unsigned size, unsigned i) {
+  for (;;) {
+    unsigned smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+    if (left < size &&
+        entryLess(cursors[heap[left]].next, cursors[heap[smallest]].next))
+      smallest = left;
+    if (right < size &&
+        entryLess(cursors[heap[right]].next, cursors[heap[smallest]].next))
+      smallest = right;
+    if (smallest == i)
+      return;
+    unsigned swap = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = swap;
+    i = smallest;
+  }
+}
+
+// k-way merge of every run's slice of the partition into a segment file,
+// counting entries per index bucket along the way
+static bool mergePartition(struct Builder *b, unsigned p,
+                           struct MergeCursor *cursors, unsigned *heap) {
+  uint64_t buckets = 1ULL << b->indexBits;
+  uint64_t first = p * buckets / b->partitions;
+  uint64_t last = (p + 1) * buckets / b->partitions;
+  unsigned size = 0;
+
+  for (unsigned r = 0; r < b->runCount; r++) {
+    const struct Run *run = &b->runs[r];
+    cursors[r].next = run->entries + lowerBoundBucket(run, first, b->indexBits);
+    cursors[r].end = run->entries + lowerBoundBucket(run, last, b->indexBits);
+    if (cursors[r].next < cursors[r].end)
+      heap[size++] = r;
+  }
+  for (unsigned i = size / 2; i-- > 0;)
+    siftDown(cursors, heap, size, i);
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s.seg%u", b->output, p);
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to write merge segment '%s'\n", path);
+    return false;
+  }
+
+  struct ExplorerEntry pending;
+  unsigned long long entries = 0, positions = 0;
+  bool havePending = false, done = false;
+  while (!done) {
+    struct ExplorerEntry entry;
+    done = size == 0;
+    if (!done) {
+      struct MergeCursor *top = &cursors[heap[0]];
+      entry = *top->next++;
+      if (top->next == top->end)
+        heap[0] = heap[--size];
+      siftDown(cursors, heap, size, 0);
+
+      if (havePending && pending.key == entry.key &&
+          pending.move == entry.move) {
+        pending.white += entry.white;
+        pending.draws += entry.draws;
+        pending.black += entry.black;
+        continue;
+      }
+    }
+
+    // Entries are grouped by key, so a new key starts a new position
+    if (havePending) {
+      b->index[bucketOf(pending.key, b->indexBits)]++;
+      fwrite(&pending, sizeof(pending), 1, file);
+      entries++;
+      positions += done || entry.key != pending.key;
+    }
+    pending = entry;
+    havePending = true;
+  }
+
+  b->segmentEntries[p] = entries;
+  b->segmentPositions[p] = positions;
+  if (fclose(file) != 0) {
+    fprintf(stderr, "Failed to write merge segment '%s'\n", path);
+    return false;
+  }
+  return true;
+}
+
+static void *mergeWorker(void *arg) {
+  struct Builder *b = (struct Builder *)arg;
+  struct MergeCursor *cursors =
+      (struct MergeCursor *)malloc(MAX_RUNS * sizeof(struct MergeCursor));
+  unsigned *heap = (unsigned *)malloc(MAX_RUNS * sizeof(unsigned));
+  bool ok = cursors != NULL && heap != NULL;
+
+  unsigned p;
+  while (ok && (p = atomic_fetch_add(&b->nextPartition, 1)) < b->partitions)
+    ok = mergePartition(b, p, cursors, heap);
+
+  free(cursors);
+  free(heap);
+  pthread_mutex_lock(&b->lock);
+  b->failed |= !ok;
+  pthread_mutex_unlock(&b->lock);
+  return NULL;
+}
+
+static bool mapFile(const char *path, const void **data, size_t *size) {
+  int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    fprintf(stderr, "Failed to open '%s'\n", path);
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
+
+  *size = st.st_size;
+  *data = NULL;
+  if (*size > 0) {
+    void *mapped = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      fprintf(stderr, "Failed to map '%s'\n", path);
+      close(fd);
+      return false;
+    }
+    madvise(mapped, *size, MADV_SEQUENTIAL);
+    *data = mapped;
+  }
+  close(fd);
+  return true;
+}
+
+// Workers take their work from shared counters, so any that start finish
+// the whole job. Returns false only when none could be started.
+static bool runThreads(unsigned count, void *(*routine)(void *), void *args,
+                       size_t argSize) {
+  pthread_t *threads = (pthread_t *)malloc(count * sizeof(pthread_t));
+  if (threads == NULL)
+    return false;
+
+  unsigned started = 0;
+  while (started < count &&
+         pthread_create(&threads[started], NULL, routine,
+                        (char *)args + started * argSize) == 0)
+    started++;
+  if (started < count)
+    fprintf(stderr, "Started %u of %u threads\n", started, count);
+  for (unsigned i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+  free(threads);
+  return started > 0;
+}
+
+// Cuts every archive into slices of roughly equal size, so one large file
+// still spreads over all workers
+static void sliceArchives(struct Builder *b) {
+  size_t total = 0;
+  for (unsigned a = 0; a < b->archiveCount; a++)
+    total += b->archives[a].length;
+  size_t target = total / (b->threads * 8) + 1;
+  if (target < SLICE_MIN_BYTES)
+    target = SLICE_MIN_BYTES;
+
+  for (unsigned a = 0; a < b->archiveCount; a++) {
+    const struct Archive *archive = &b->archives[a];
+    size_t begin = 0;
+    while (begin < archive->length && b->sliceCount < MAX_SLICES) {
+      size_t end = b->sliceCount + 1 == MAX_SLICES
+                       ? archive->length
+                       : FindPgnGameStart(archive->text, archive->length,
+                                          begin + target);
+      b->slices[b->sliceCount++] = (struct Slice){archive, begin, end};
+      begin = end;
+    }
+  }
+}
+
+static bool copySegment(FILE *out, const char *path, char *buffer) {
+  FILE *in = fopen(path, "rb");
+  if (in == NULL)
+    return false;
+
+  size_t n;
+  bool ok = true;
+  while (ok && (n = fread(buffer, 1, COPY_BUFFER_BYTES, in)) > 0)
+    ok = fwrite(buffer, 1, n, out) == n;
+  fclose(in);
+  remove(path);
+  return ok;
+}
+
+static bool writeDatabase(struct Builder *b) {
+  uint64_t buckets = 1ULL << b->indexBits;
+  struct ExplorerHeader header = {
+      .magic = EXPLORER_MAGIC,
+      .version = EXPLORER_VERSION,
+      .byteOrder = EXPLORER_BYTE_ORDER,
+      .indexBits = b->indexBits,
+      .gameCount = b->games,
+  };
+  for (unsigned p = 0; p < b->partitions; p++) {
+    header.entryCount += b->segmentEntries[p];
+    header.positionCount += b->segmentPositions[p];
+  }
+
+  uint64_t offset = 0;
+  for (uint64_t i = 0; i <= buckets; i++) {
+    uint64_t count = i < buckets ? b->index[i] : 0;
+    b->index[i] = offset;
+    offset += count;
+  }
+
+  FILE *out = fopen(b->output, "wb");
+  char *buffer = (char *)malloc(COPY_BUFFER_BYTES);
+  bool ok = out != NULL && buffer != NULL &&
+            fwrite(&header, sizeof(header), 1, out) == 1;
+  for (unsigned p = 0; ok && p < b->partitions; p++) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s.seg%u", b->output, p);
+    ok = copySegment(out, path, buffer);
+  }
+  ok = ok &&
+       fwrite(b->index, sizeof(uint64_t), buckets + 1, out) == buckets + 1;
+
+  free(buffer);
+  if (out != NULL && fclose(out) != 0)
+    ok = false;
+  if (!ok)
+    fprintf(stderr, "Failed to write database '%s'\n", b->output);
+  return ok;
+}
+
+static int build(int argc, char **argv) {
+  static struct Builder b;
+  size_t chunkMb = 128;
+  b.threads = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+
+  int first = 0;
+  for (; first + 1 < argc && strncmp(argv[first], "--", 2) == 0; first += 2) {
+    const char *value = argv[first + 1];
+    if (strcmp(argv[first], "--threads") == 0)
+      b.threads = (unsigned)atoi(value);
+    else if (strcmp(argv[first], "--chunk-mb") == 0)
+      chunkMb = (size_t)atoll(value);
+    else if (strcmp(argv[first], "--max-ply") == 0)
+      b.maxPly = (unsigned)atoi(value);
+    else if (strcmp(argv[first], "--output") == 0)
+      b.output = value;
+    else {
+      fprintf(stderr, "Unknown option '%s'\n", argv[first]);
+      return 1;
+    }
+  }
+  if (b.output == NULL || first >= argc) {
+    fprintf(stderr, "Usage: openings build [--threads N] [--chunk-mb N] "
+                    "[--max-ply N] --output db archive.pgn...\n");
+    return 1;
+  }
+  if (b.threads == 0)
+    b.threads = 1;
+  // Each worker holds a chunk and a radix sort buffer of the same size
+  b.chunkEntries = chunkMb * (1 << 20) / (2 * sizeof(struct ExplorerEntry));
+  if (b.chunkEntries < 1024)
+    b.chunkEntries = 1024;
+
+  b.archiveCount = argc - first;
+  b.archives = (struct Archive *)calloc(b.archiveCount, sizeof(struct Archive));
+  size_t totalBytes = 0;
+  for (unsigned a = 0; a < b.archiveCount; a++) {
+    b.archives[a].path = argv[first + a];
+    if (!mapFile(b.archives[a].path, (const void **)&b.archives[a].text,
+                 &b.archives[a].length))
+      return 1;
+    totalBytes += b.archives[a].length;
+  }
+  sliceArchives(&b);
+  pthread_mutex_init(&b.lock, NULL);
+  atomic_init(&b.nextSlice, 0);
+  printf("%u archives, %.1f MB in %u slices, %u threads, %zu MB chunks\n",
+         b.archiveCount, totalBytes / 1e6, b.sliceCount, b.threads, chunkMb);
+
+  // Phase 1: replay games and spill sorted runs
+  long long start = GetMonotonicTimeNs();
+  struct ParseWorker *workers =
+      (struct ParseWorker *)calloc(b.threads, sizeof(struct ParseWorker));
+  for (unsigned i = 0; i < b.threads; i++) {
+    workers[i].builder = &b;
+    workers[i].game = NewGame();
+    workers[i].chunk = (struct ExplorerEntry *)malloc(
+        b.chunkEntries * sizeof(struct ExplorerEntry));
+    workers[i].scratch = (struct ExplorerEntry *)malloc(
+        b.chunkEntries * sizeof(struct ExplorerEntry));
+    workers[i].histogram = (size_t *)malloc(65536 * sizeof(size_t));
+    if (workers[i].game == NULL || workers[i].chunk == NULL ||
+        workers[i].scratch == NULL || workers[i].histogram == NULL) {
+      fprintf(stderr, "Failed to allocate worker buffers\n");
+      return 1;
+    }
+  }
+  b.failed |=
+      !runThreads(b.threads, parseWorker, workers, sizeof(struct ParseWorker));
+  for (unsigned i = 0; i < b.threads; i++) {
+    DeleteGame(workers[i].game);
+    free(workers[i].chunk);
+    free(workers[i].scratch);
+    free(workers[i].histogram);
+  }
+  free(workers);
+  for (unsigned a = 0; a < b.archiveCount; a++)
+    munmap((void *)b.archives[a].text, b.archives[a].length);
+  double parseSeconds = (GetMonotonicTimeNs() - start) / 1e9;
+  if (b.failed)
+    return 1;
+
+  printf("replay+sort: %llu games (%llu skipped, %llu cut short at castling, "
+         "en passant or promotion)\n",
+         b.games, b.skipped, b.truncated);
+  printf("             %llu positions in %.2f s: %.0f positions/s, %.1f MB/s, "
+         "%u runs\n",
+         b.records, parseSeconds,
+         parseSeconds > 0 ? b.records / parseSeconds : 0.0,
+         parseSeconds > 0 ? totalBytes / 1e6 / parseSeconds : 0.0, b.runCount);
+
+  // Phase 2: merge the runs, one key range per task
+  start = GetMonotonicTimeNs();
+  size_t runEntries = 0;
+  for (unsigned r = 0; r < b.runCount; r++) {
+    size_t size;
+    if (!mapFile(b.runs[r].path, (const void **)&b.runs[r].entries, &size))
+      return 1;
+    runEntries += b.runs[r].count;
+  }
+  // Sized from the record count rather than the runs, so the file does not
+  // depend on the thread count or chunk size
+  while (b.indexBits < INDEX_MAX_BITS && (4ULL << b.indexBits) <= b.records)
+    b.indexBits++;
+  b.partitions = b.threads * 4;
+  if (b.partitions > (1u << b.indexBits))
+    b.partitions = 1u << b.indexBits;
+  b.index = (uint64_t *)calloc((1ULL << b.indexBits) + 1, sizeof(uint64_t));
+  b.segmentEntries =
+      (unsigned long long *)calloc(b.partitions, sizeof(unsigned long long));
+  b.segmentPositions =
+      (unsigned long long *)calloc(b.partitions, sizeof(unsigned long long));
+  if (b.index == NULL || b.segmentEntries == NULL ||
+      b.segmentPositions == NULL) {
+    fprintf(stderr, "Failed to allocate the merge index\n");
+    return 1;
+  }
+  atomic_init(&b.nextPartition, 0);
+
+  // Every merge thread reads the same builder, so the argument stride is 0
+  b.failed |= !runThreads(b.threads, mergeWorker, &b, 0);
+  for (unsigned r = 0; r < b.runCount; r++) {
+    if (b.runs[r].entries != NULL)
+      munmap((void *)b.runs[r].entries,
+             b.runs[r].count * sizeof(struct ExplorerEntry));
+    remove(b.runs[r].path);
+  }
+  double mergeSeconds = (GetMonotonicTimeNs() - start) / 1e9;
+  if (b.failed)
+    return 1;
+
+  start = GetMonotonicTimeNs();
+  if (!writeDatabase(&b))
+    return 1;
+  double writeSeconds = (GetMonotonicTimeNs() - start) / 1e9;
+
+  const struct ExplorerHeader *header = NULL;
+  struct Explorer explorer;
+  if (OpenExplorer(&explorer, b.output))
+    header = explorer.header;
+  printf("merge:       %zu run entries in %.2f s: %.0f entries/s\n", runEntries,
+         mergeSeconds, mergeSeconds > 0 ? runEntries / mergeSeconds : 0.0);
+  printf("write:       %.2f s\n", writeSeconds);
+  if (header != NULL) {
+    printf("database:    %llu positions, %llu moves, %u index bits, %.1f MB\n",
+           (unsigned long long)header->positionCount,
+           (unsigned long long)header->entryCount, header->indexBits,
+           explorer.size / 1e6);
+    CloseExplorer(&explorer);
+  }
+  printf("total:       %.2f s, %.0f positions/s\n",
+         parseSeconds + mergeSeconds + writeSeconds,
+         b.records / (parseSeconds + mergeSeconds + writeSeconds));
+
+  free(b.index);
+  free(b.segmentEntries);
+  free(b.segmentPositions);
+  free(b.archives);
+  pthread_mutex_destroy(&b.lock);
+  return header != NULL ? 0 : 1;
+}
+
+static int query(int argc, char **argv) {
+  if (argc < 1) {
+    fprintf(stderr, "Usage: openings query db [--fen FEN] [move...]\n");
+    return 1;
+  }
+
+  struct Explorer explorer;
+  if (!OpenExplorer(&explorer, argv[0]))
+    return 1;
+  struct Game *game = NewGame();
+  int i = 1;
+  if (i + 1 < argc && strcmp(argv[i], "--fen") == 0) {
+    if (!LoadFEN(game, argv[i + 1]))
+      return 1;
+    i += 2;
+  }
+  for (; i < argc; i++) {
+    struct Move move;
+    struct Undo undo;
+    if (!ParseSAN(game, argv[i], &move)) {
+      fprintf(stderr, "Cannot play '%s' in this position\n", argv[i]);
+      return 1;
+    }
+    MakeMove(game, move, &undo);
+  }
+
+  struct ExplorerMove moves[QUERY_MAX_MOVES];
+  long long start = GetMonotonicTimeNs();
+  unsigned count = QueryExplorer(&explorer, GetPositionHash(game), moves,
+                                 QUERY_MAX_MOVES);
+  long long elapsed = GetMonotonicTimeNs() - start;
+
+  printf("position %016llx: %u moves (%lld ns)\n",
+         (unsigned long long)GetPositionHash(game), count, elapsed);
+  for (unsigned m = 0; m < count && m < QUERY_MAX_MOVES; m++) {
+    char san[8];
+    double games = moves[m].white + moves[m].draws + moves[m].black;
+    FormatSAN(game, moves[m].move, san, sizeof(san));
+    printf("  %-6s %8.0f games  white %5.1f%%  draw %5.1f%%  black %5.1f%%\n",
+           san, games, 100 * moves[m].white / games,
+           100 * moves[m].draws / games, 100 * moves[m].black / games);
+  }
+
+  DeleteGame(game);
+  CloseExplorer(&explorer);
+  return 0;
+}
+
+static int compareLatencies(const void *a, const void *b) {
+  long long x = *(const long long *)a, y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+static void reportLatencies(const char *name, long long *latencies,
+                            size_t count) {
+  if (count == 0)
+    return;
+  qsort(latencies, count, sizeof(*latencies), compareLatencies);
+  printf("  %-12s median %5lld ns  p99 %6lld ns  max %8lld ns\n", name,
+         latencies[count / 2], latencies[(size_t)(count * 0.99)],
+         latencies[count - 1]);
+}
+
+// Times single queries on a fresh mapping: the first pass pays for the
+// page faults, the second one runs from memory. Half the keys exist in the
+// database, the other half are random misses. Sampling the hits reads their
+// pages, so the database is closed and dropped from the page cache before
+// the cold pass; only the index, read when the database is opened, is warm.
+static int bench(int argc, char **argv) {
+  size_t queries = 1000000;
+  if (argc < 1) {
+    fprintf(stderr, "Usage: openings bench db [--queries N]\n");
+    return 1;
+  }
+  if (argc > 2 && strcmp(argv[1], "--queries") == 0)
+    queries = (size_t)atoll(argv[2]);
+
+  struct Explorer explorer;
+  if (!OpenExplorer(&explorer, argv[0]) || explorer.header->entryCount == 0)
+    return 1;
+
+  uint64_t *keys = (uint64_t *)malloc(queries * sizeof(uint64_t));
+  long long *hits = (long long *)malloc(queries * sizeof(long long));
+  long long *misses = (long long *)malloc(queries * sizeof(long long));
+  if (keys == NULL || hits == NULL || misses == NULL)
+    return 1;
+
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  for (size_t i = 0; i < queries; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    keys[i] = i % 2 == 0
+                  ? explorer.entries[state % explorer.header->entryCount].key
+                  : state;
+  }
+
+  CloseExplorer(&explorer);
+  int fd = open(argv[0], O_RDONLY);
+  if (fd >= 0) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+  if (!OpenExplorer(&explorer, argv[0]))
+    return 1;
+
+  printf("%zu queries against %llu positions\n", queries,
+         (unsigned long long)explorer.header->positionCount);
+  for (int pass = 0; pass < 2; pass++) {
+    struct ExplorerMove moves[QUERY_MAX_MOVES];
+    size_t hitCount = 0, missCount = 0;
+    long long passStart = GetMonotonicTimeNs();
+
+    for (size_t i = 0; i < queries; i++) {
+      long long start = GetMonotonicTimeNs();
+      unsigned found =
+          QueryExplorer(&explorer, keys[i], moves, QUERY_MAX_MOVES);
+      long long elapsed = GetMonotonicTimeNs() - start;
+      if (found > 0)
+        hits[hitCount++] = elapsed;
+      else
+        misses[missCount++] = elapsed;
+    }
+
+    double seconds = (GetMonotonicTimeNs() - passStart) / 1e9;
+    printf("%s pass: %.0f queries/s\n", pass == 0 ? "cold" : "warm",
+           seconds > 0 ? queries / seconds : 0.0);
+    reportLatencies("hits", hits, hitCount);
+    reportLatencies("misses", misses, missCount);
+  }
+
+  free(keys);
+  free(hits);
+  free(misses);
+  CloseExplorer(&explorer);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  SetTraceLogLevel(LOG_WARNING);
+  if (argc >= 2 && strcmp(argv[1], "build") == 0)
+    return build(argc - 2, argv + 2);
+  if (argc >= 2 && strcmp(argv[1], "query") == 0)
+    return query(argc - 2, argv + 2);
+  if (argc >= 2 && strcmp(argv[1], "bench") == 0)
+    return bench(argc - 2, argv + 2);
+
+  fprintf(stderr, "Usage: %s build|query|bench ...\n", argv[0]);
+  return 1;
+}
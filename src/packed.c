@@ -0,0 +1,74 @@
+#include "packed.h"
+
+#include <string.h>
+
+_Static_assert(sizeof(struct PackedPosition) == 32,
+               "packed positions must stay 32 bytes");
+
+void PackPosition(const struct Game *game, enum GameResult result, int ply,
+                  int whiteScore, struct PackedPosition *out) {
+  memset(out, 0, sizeof(*out));
+
+  unsigned count = 0;
+  for (int square = 0; square < 64 && count < 32; square++) {
+    const struct Piece *p =
+        game->board->pieces[SQUARE_X(square)][SQUARE_Y(square)];
+    if (p == NULL)
+      continue;
+
+    unsigned code = p->player * 6 + p->type;
+    out->occupancy |= 1ULL << square;
+    out->pieces[count / 2] |= (uint8_t)(code << (4 * (count % 2)));
+    count++;
+  }
+
+  out->sideToMove = GetCurrentPlayer(game);
+  if (result == ResultWhiteWins)
+    out->result = 2;
+  else if (result == ResultDraw)
+    out->result = 1;
+  out->ply = ply > UINT16_MAX ? UINT16_MAX : (uint16_t)ply;
+  if (whiteScore != PACKED_NO_SCORE && whiteScore < -INT16_MAX)
+    whiteScore = -INT16_MAX;
+  out->score = whiteScore > INT16_MAX ? INT16_MAX : (int16_t)whiteScore;
+}
+
+// Restores the placement and side to move, the same subset of a position a
+// FEN carries for this board
+bool UnpackPosition(const struct PackedPosition *packed, struct Game *game) {
+  char fen[96];
+  int n = 0;
+
+  // Only 32 pieces fit in the nibble array; more would read past its end
+  if (__builtin_popcountll(packed->occupancy) > 32)
+    return false;
+
+  for (int y = 0; y < 8; y++) {
+    int empty = 0;
+    for (int x = 0; x < 8; x++) {
+      int square = SQUARE_INDEX(x, y);
+      if (!((packed->occupancy >> square) & 1)) {
+        empty++;
+        continue;
+      }
+
+      uint64_t below = packed->occupancy & ((1ULL << square) - 1);
+      int index = __builtin_popcountll(below);
+      unsigned code = (packed->pieces[index / 2] >> (4 * (index % 2))) & 15;
+      if (code >= 12)
+        return false;
+      if (empty > 0)
+        fen[n++] = (char)('0' + empty);
+      empty = 0;
+      char letter = "PNBKRQ"[code % 6];
+      fen[n++] = code >= 6 ? (char)(letter + 32) : letter;
+    }
+    if (empty > 0)
+      fen[n++] = (char)('0' + empty);
+    fen[n++] = y < 7 ? '/' : ' ';
+  }
+  fen[n++] = packed->sideToMove == BlackPlayer ? 'b' : 'w';
+  fen[n] = '\0';
+
+  return LoadFEN(game, fen);
+}
@@ -0,0 +1,29 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include "game.h"
+#include "pgn.h"
+
+#define PACKED_NO_SCORE INT16_MIN
+
+// Fixed-width training sample, 32 bytes. Occupied squares are listed in
+// `occupancy` (bit SQUARE_INDEX(x, y)); their pieces follow in square order,
+// one nibble each holding player * 6 + type, low nibble first. Files of
+// these records are read by mapping them, so the layout is the host's.
+struct PackedPosition {
+  uint64_t occupancy;
+  uint8_t pieces[16];
+  uint8_t sideToMove;
+  // 0 black won, 1 draw, 2 white won: the white score doubled
+  uint8_t result;
+  uint16_t ply;
+  // Search score from white's point of view, PACKED_NO_SCORE if unknown
+  int16_t score;
+  uint16_t reserved;
+};
+
+void PackPosition(const struct Game *game, enum GameResult result, int ply,
+                  int whiteScore, struct PackedPosition *out);
+bool UnpackPosition(const struct PackedPosition *packed, struct Game *game);
+
+#endif // PACKED_H
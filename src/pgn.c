@@ -0,0 +1,287 @@
+#include "pgn.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include "see.h"
+
+// SAN letters indexed by enum PieceType
+static const char pieceLetters[] = "PNBKRQ";
+
+size_t FindPgnGameStart(const char *text, size_t length, size_t offset) {
+  static const char marker[] = "\n[Event ";
+  const size_t markerLength = sizeof(marker) - 1;
+
+  if (offset == 0)
+    return 0;
+  for (size_t i = offset - 1; i + markerLength <= length; i++) {
+    const char *newline = memchr(text + i, '\n', length - i);
+    if (newline == NULL)
+      break;
+    i = newline - text;
+    if (i + markerLength <= length &&
+        memcmp(text + i, marker, markerLength) == 0)
+      return i + 1;
+  }
+  return length;
+}
+
+static void parseTag(const char *line, size_t length, struct PgnGame *game) {
+  const char *value = memchr(line, '"', length);
+  if (value == NULL)
+    return;
+  value++;
+  const char *valueEnd = memchr(value, '"', line + length - value);
+  if (valueEnd == NULL)
+    return;
+  size_t valueLength = valueEnd - value;
+
+  if (length > 8 && memcmp(line, "[Result ", 8) == 0) {
+    if (valueLength == 3 && memcmp(value, "1-0", 3) == 0)
+      game->result = ResultWhiteWins;
+    else if (valueLength == 3 && memcmp(value, "0-1", 3) == 0)
+      game->result = ResultBlackWins;
+    else if (valueLength == 7 && memcmp(value, "1/2-1/2", 7) == 0)
+      game->result = ResultDraw;
+  } else if (length > 5 && memcmp(line, "[FEN ", 5) == 0 &&
+             valueLength < sizeof(game->fen)) {
+    memcpy(game->fen, value, valueLength);
+    game->fen[valueLength] = '\0';
+  }
+}
+
+bool NextPgnGame(const char *text, size_t length, size_t *offset,
+                 struct PgnGame *game) {
+  size_t i = *offset;
+  while (i < length && isspace((unsigned char)text[i]))
+    i++;
+  if (i >= length) {
+    *offset = length;
+    return false;
+  }
+
+  game->result = ResultUnknown;
+  game->fen[0] = '\0';
+  while (i < length && text[i] == '[') {
+    size_t lineEnd = i;
+    while (lineEnd < length && text[lineEnd] != '\n')
+      lineEnd++;
+    parseTag(text + i, lineEnd - i, game);
+    i = lineEnd;
+    while (i < length && isspace((unsigned char)text[i]))
+      i++;
+  }
+
+  // The movetext runs up to the next tag line; brace comments may span
+  // lines and are allowed to contain brackets
+  size_t start = i;
+  bool inComment = false;
+  for (; i < length; i++) {
+    if (inComment) {
+      inComment = text[i] != '}';
+    } else if (text[i] == '{') {
+      inComment = true;
+    } else if (text[i] == '[' && text[i - 1] == '\n') {
+      break;
+    }
+  }
+
+  game->movetext = text + start;
+  game->movetextLength = i - start;
+  *offset = i;
+  return true;
+}
+
+static bool startsWith(const char *p, const char *end, const char *prefix) {
+  size_t length = strlen(prefix);
+  return (size_t)(end - p) >= length && memcmp(p, prefix, length) == 0;
+}
+
+bool NextSanToken(const char **cursor, const char *end, char *token,
+                  size_t tokenSize) {
+  const char *p = *cursor;
+
+  while (p < end) {
+    char c = *p;
+    if (isspace((unsigned char)c) || c == '.') {
+      p++;
+    } else if (c == '{') {
+      while (p < end && *p != '}')
+        p++;
+      p++;
+    } else if (c == ';') {
+      while (p < end && *p != '\n')
+        p++;
+    } else if (c == '(') {
+      int depth = 0;
+      do {
+        depth += (*p == '(') - (*p == ')');
+        p++;
+      } while (p < end && depth > 0);
+    } else if (c == '$') {
+      p++;
+      while (p < end && isdigit((unsigned char)*p))
+        p++;
+    } else if (c == '*' || startsWith(p, end, "1-0") ||
+               startsWith(p, end, "0-1") || startsWith(p, end, "1/2-1/2")) {
+      *cursor = end;
+      return false;
+    } else if (isdigit((unsigned char)c) && !startsWith(p, end, "0-0")) {
+      while (p < end && isdigit((unsigned char)*p))
+        p++;
+    } else {
+      size_t n = 0;
+      while (p < end && !isspace((unsigned char)*p) &&
+             strchr("{}();$", *p) == NULL) {
+        if (n + 1 < tokenSize)
+          token[n++] = *p;
+        p++;
+      }
+      token[n] = '\0';
+      *cursor = p;
+      return true;
+    }
+  }
+
+  *cursor = end;
+  return false;
+}
+
+static bool leavesKingAttacked(struct Game *game, struct Move move) {
+  enum Player side = GetCurrentPlayer(game);
+  struct Undo undo;
+
+  MakeMove(game, move, &undo);
+  bool attacked = IsInCheck(game, side);
+  UnmakeMove(game, &undo);
+  return attacked;
+}
+
+bool ParseSAN(struct Game *game, const char *san, struct Move *move) {
+  char buffer[16];
+  size_t n = strlen(san);
+  if (n >= sizeof(buffer))
+    return false;
+  memcpy(buffer, san, n + 1);
+  while (n > 0 && strchr("+#!?", buffer[n - 1]) != NULL)
+    buffer[--n] = '\0';
+
+  // Castling and promotion have no counterpart on this board
+  if (n < 2 || buffer[0] == 'O' || buffer[0] == '0' ||
+      strchr(buffer, '=') != NULL)
+    return false;
+
+  enum PieceType type = Pawn;
+  size_t i = 0;
+  const char *letter = strchr(pieceLetters + 1, buffer[0]);
+  if (letter != NULL) {
+    type = (enum PieceType)(letter - pieceLetters);
+    i = 1;
+  }
+
+  if (n < i + 2)
+    return false;
+  char toFile = buffer[n - 2], toRank = buffer[n - 1];
+  if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8')
+    return false;
+  int to = SQUARE_INDEX(toFile - 'a', '8' - toRank);
+
+  int fromX = -1, fromY = -1;
+  for (; i < n - 2; i++) {
+    if (buffer[i] >= 'a' && buffer[i] <= 'h')
+      fromX = buffer[i] - 'a';
+    else if (buffer[i] >= '1' && buffer[i] <= '8')
+      fromY = '8' - buffer[i];
+    else if (buffer[i] != 'x' && buffer[i] != ':')
+      return false;
+  }
+  // Pawn pushes name no origin, they come from the destination file
+  if (type == Pawn && fromX < 0)
+    fromX = SQUARE_X(to);
+
+  struct Move candidates[16];
+  int count = 0;
+  enum Player side = GetCurrentPlayer(game);
+  for (int x = 0; x < 8; x++) {
+    for (int y = 0; y < 8; y++) {
+      const struct Piece *p = game->board->pieces[x][y];
+      if (p == NULL || p->player != side || p->type != type ||
+          (fromX >= 0 && x != fromX) || (fromY >= 0 && y != fromY))
+        continue;
+
+      Vector2 from = {x, y};
+      if ((GetPossibleTargets(game, &from) >> to) & 1 && count < 16)
+        candidates[count++] = (struct Move){SQUARE_INDEX(x, y), to};
+    }
+  }
+  if (count == 1) {
+    *move = candidates[0];
+    return true;
+  }
+
+  // SAN leaves out pinned pieces when disambiguating, so several
+  // candidates can still name exactly one legal move
+  int legal = 0;
+  for (int k = 0; k < count; k++) {
+    if (!leavesKingAttacked(game, candidates[k])) {
+      *move = candidates[k];
+      legal++;
+    }
+  }
+  return legal == 1;
+}
+
+void FormatSquare(int square, char out[3]) {
+  out[0] = (char)('a' + SQUARE_X(square));
+  out[1] = (char)('8' - SQUARE_Y(square));
+  out[2] = '\0';
+}
+
+void FormatSAN(struct Game *game, struct Move move, char *out,
+               size_t outSize) {
+  int fromX = SQUARE_X(move.from), fromY = SQUARE_Y(move.from);
+  const struct Piece *piece = game->board->pieces[fromX][fromY];
+  bool capture =
+      game->board->pieces[SQUARE_X(move.to)][SQUARE_Y(move.to)] != NULL;
+  char buffer[8];
+  int n = 0;
+
+  if (piece == NULL) {
+    snprintf(out, outSize, "--");
+    return;
+  }
+
+  if (piece->type == Pawn) {
+    if (capture)
+      buffer[n++] = (char)('a' + fromX);
+  } else {
+    buffer[n++] = pieceLetters[piece->type];
+
+    bool ambiguous = false, sameFile = false, sameRank = false;
+    for (int x = 0; x < 8; x++) {
+      for (int y = 0; y < 8; y++) {
+        const struct Piece *p = game->board->pieces[x][y];
+        Vector2 from = {x, y};
+        // Only legal moves count: a pinned twin needs no disambiguation
+        if (p == NULL || p == piece || p->player != piece->player ||
+            p->type != piece->type ||
+            !((GetPossibleTargets(game, &from) >> move.to) & 1) ||
+            leavesKingAttacked(game,
+                               (struct Move){SQUARE_INDEX(x, y), move.to}))
+          continue;
+        ambiguous = true;
+        sameFile |= x == fromX;
+        sameRank |= y == fromY;
+      }
+    }
+    if (ambiguous && (!sameFile || sameRank))
+      buffer[n++] = (char)('a' + fromX);
+    if (ambiguous && sameFile)
+      buffer[n++] = (char)('8' - fromY);
+  }
+
+  if (capture)
+    buffer[n++] = 'x';
+  FormatSquare(move.to, buffer + n);
+  snprintf(out, outSize, "%s", buffer);
+}
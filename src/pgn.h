@@ -0,0 +1,46 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include "game.h"
+
+enum GameResult {
+  ResultUnknown = 0,
+  ResultWhiteWins,
+  ResultDraw,
+  ResultBlackWins,
+};
+
+// One game of a PGN archive. The movetext points into the archive buffer
+// and is not NUL terminated.
+struct PgnGame {
+  enum GameResult result;
+  // Starting position from the FEN tag, empty for the standard setup
+  char fen[128];
+  const char *movetext;
+  size_t movetextLength;
+};
+
+// Splits archives at game boundaries, so independent workers can each take
+// a slice of one file. Returns the offset of the first game at or after
+// `offset`, or `length` when there is none.
+size_t FindPgnGameStart(const char *text, size_t length, size_t offset);
+// Parses the game at text[*offset] and advances past it. Returns false at
+// the end of the buffer.
+bool NextPgnGame(const char *text, size_t length, size_t *offset,
+                 struct PgnGame *game);
+// Reads the next move token of a movetext, skipping move numbers, comments,
+// variations and annotation glyphs. Returns false at the game termination
+// marker or the end of the movetext.
+bool NextSanToken(const char **cursor, const char *end, char *token,
+                  size_t tokenSize);
+
+// Resolves a SAN move for the side to move. Fails for moves the board
+// cannot play: castling, en passant and promotion are not implemented.
+bool ParseSAN(struct Game *game, const char *san, struct Move *move);
+// Writes a SAN move without check markers. Candidate moves are tried on the
+// game to disambiguate, which is returned in the position it was given.
+void FormatSAN(struct Game *game, struct Move move, char *out,
+               size_t outSize);
+void FormatSquare(int square, char out[3]);
+
+#endif // PGN_H
@@ -0,0 +1,38 @@
+#include "positions.h"
+
+const char *const BenchmarkPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1",
+    "r1bqk1nr/pppp1ppp/2n5/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w - - 4 4",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w - - 0 8",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w - - 0 1",
+    "r2q1rk1/1b2bppp/p2p1n2/1p2p3/3NP3/1BN1B3/PPP2PPP/R2QR1K1 w - - 0 12",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "2r3k1/pp3ppp/2n1b3/3p4/3P4/2PB1N2/P4PPP/R5K1 w - - 0 20",
+    "8/5pk1/6p1/2R5/8/6P1/5PK1/3r4 w - - 0 40",
+};
+
+const unsigned BenchmarkPositionCount =
+    sizeof(BenchmarkPositions) / sizeof(BenchmarkPositions[0]);
+
+// Mates needing none of castling, en passant or promotion, which the board
+// cannot play. A mate of zero marks a position with no mate within the limit.
+const struct MateProblem MateProblems[] = {
+    {"6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", 1, 1},
+    {"r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w - - 4 4", 1, 1},
+    {"rnbqkbnr/pppp1ppp/8/4p3/6P1/5P2/PPPPP2P/RNBQKBNR b - - 0 2", 1, 1},
+    {"kbK5/pp6/1P6/8/8/8/8/R7 w - - 0 1", 2, 2},
+    {"r1b2k1r/ppp1bppp/8/1B1Q4/5q2/2P5/PPP2PPP/R3R1K1 w - - 1 1", 2, 2},
+    {"r2qkbnr/ppp2ppp/2np4/4N3/2B1P1b1/2N5/PPPP1PPP/R1BbK2R w - - 0 6", 2, 2},
+    {"7k/8/8/8/8/8/R7/1R4K1 w - - 0 1", 2, 2},
+    {"R7/8/8/8/8/4K3/8/6k1 w - - 0 1", 3, 3},
+    {"r6k/6pp/8/6N1/2Q5/8/6PP/6K1 w - - 0 1", 4, 4},
+    {"8/8/8/3k4/8/8/8/KR5R w - - 0 1", 6, 6},
+    {"k7/2Q5/1K6/8/8/8/8/8 b - - 0 1", 0, 1},
+    {"k7/8/1Q6/8/8/8/8/K7 w - - 0 1", 0, 2},
+    {"8/8/8/8/8/2k5/8/2K4R w - - 0 1", 0, 3},
+    {"r5k1/5ppp/8/8/8/8/1Q3PPP/3R2K1 w - - 0 1", 0, 3},
+    {"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w - - 0 8", 0, 2},
+};
+
+const unsigned MateProblemCount =
+    sizeof(MateProblems) / sizeof(MateProblems[0]);
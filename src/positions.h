@@ -0,0 +1,19 @@
+#ifndef POSITIONS_H
+#define POSITIONS_H
+
+// Curated FENs covering opening, middlegame and endgame material, shared by
+// the headless measurement tools
+extern const char *const BenchmarkPositions[];
+extern const unsigned BenchmarkPositionCount;
+
+struct MateProblem {
+  const char *fen;
+  // Mate length in moves, zero if there is none within the limit
+  int mate;
+  int limit;
+};
+
+extern const struct MateProblem MateProblems[];
+extern const unsigned MateProblemCount;
+
+#endif // POSITIONS_H
@@ -0,0 +1,138 @@
+// Headless replay of recorded input sessions through update().
+//
+// Usage: ./replay [--repeat N] [--budget-ns N] recording...
+//
+// Each recording is replayed from a fresh game, checked against the
+// position hash stored when it was recorded, and every frame's update()
+// is timed. Exits with 1 when a replay diverges or the p99 frame cost is
+// over budget, so recorded sessions can serve as regression tests.
+
+#include <string.h>
+
+#include "input.h"
+#include "tools.h"
+#include "ui.h"
+
+#define HISTOGRAM_BUCKETS 24
+#define HISTOGRAM_WIDTH 40
+
+static int compareCosts(const void *a, const void *b) {
+  long long x = *(const long long *)a, y = *(const long long *)b;
+  return (x > y) - (x < y);
+}
+
+// Power-of-two buckets: bucket i holds costs in [2^i, 2^(i+1)) ns
+static void printHistogram(const long long *costs, size_t count) {
+  size_t buckets[HISTOGRAM_BUCKETS] = {0};
+  size_t largest = 0;
+  int first = HISTOGRAM_BUCKETS, last = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    int bucket = 0;
+    while (bucket < HISTOGRAM_BUCKETS - 1 && (costs[i] >> (bucket + 1)) != 0)
+      bucket++;
+    buckets[bucket]++;
+  }
+  for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+    if (buckets[b] == 0)
+      continue;
+    first = b < first ? b : first;
+    last = b;
+    largest = buckets[b] > largest ? buckets[b] : largest;
+  }
+
+  for (int b = first; b <= last; b++) {
+    int width = (int)(buckets[b] * HISTOGRAM_WIDTH / largest);
+    printf("  %9lld ns  |%-*.*s %zu\n", 1LL << b, HISTOGRAM_WIDTH, width,
+           "########################################", buckets[b]);
+  }
+}
+
+static bool replay(const char *path, unsigned repeat, long long budgetNs) {
+  struct InputRecording recording;
+  if (!LoadInputRecording(&recording, path))
+    return false;
+
+  size_t count = (size_t)recording.frameCount * repeat;
+  long long *costs = (long long *)malloc((count ? count : 1) * sizeof(*costs));
+  if (costs == NULL) {
+    UnloadInputRecording(&recording);
+    return false;
+  }
+
+  bool ok = true;
+  size_t next = 0;
+  for (unsigned r = 0; r < repeat; r++) {
+    ResetDefaultConfiguration(game);
+    selected = NULL;
+
+    for (uint32_t f = 0; f < recording.frameCount; f++) {
+      long long start = GetMonotonicTimeNs();
+      update(&recording.frames[f]);
+      costs[next++] = GetMonotonicTimeNs() - start;
+    }
+
+    if (GetPositionHash(game) != recording.finalHash) {
+      printf("%s: replay diverged, final hash %016llx expected %016llx\n",
+             path, (unsigned long long)GetPositionHash(game),
+             (unsigned long long)recording.finalHash);
+      ok = false;
+      break;
+    }
+  }
+
+  if (ok && count > 0) {
+    qsort(costs, count, sizeof(*costs), compareCosts);
+    long long p99 = costs[(size_t)(count * 0.99)];
+    printf("%s: %u frames x %u, median %lld ns, p99 %lld ns, max %lld ns\n",
+           path, recording.frameCount, repeat, costs[count / 2], p99,
+           costs[count - 1]);
+    printHistogram(costs, count);
+
+    if (budgetNs > 0 && p99 > budgetNs) {
+      printf("%s: p99 frame cost %lld ns is over the %lld ns budget\n", path,
+             p99, budgetNs);
+      ok = false;
+    }
+  }
+
+  free(costs);
+  UnloadInputRecording(&recording);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  unsigned repeat = 100;
+  long long budgetNs = 0;
+  int first = 1;
+
+  for (; first + 1 < argc && strncmp(argv[first], "--", 2) == 0; first += 2) {
+    if (strcmp(argv[first], "--repeat") == 0)
+      repeat = (unsigned)atoi(argv[first + 1]);
+    else if (strcmp(argv[first], "--budget-ns") == 0)
+      budgetNs = atoll(argv[first + 1]);
+    else {
+      fprintf(stderr, "Unknown option '%s'\n", argv[first]);
+      return 1;
+    }
+  }
+  if (first >= argc) {
+    fprintf(stderr, "Usage: %s [--repeat N] [--budget-ns N] recording...\n",
+            argv[0]);
+    return 1;
+  }
+  if (repeat == 0)
+    repeat = 1;
+
+  SetAppTraceLogLevel(LOG_WARNING);
+  game = NewGame();
+  if (game == NULL)
+    return 1;
+
+  bool ok = true;
+  for (int i = first; i < argc; i++)
+    ok = replay(argv[i], repeat, budgetNs) && ok;
+
+  DeleteGame(game);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,353 @@
+#include "search.h"
+#include "eval.h"
+
+#include <string.h>
+#include <time.h>
+
+long long GetMonotonicTimeMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+bool NewTranspositionTable(struct TranspositionTable *tt, size_t megabytes) {
+  size_t count = 1;
+  while (count * 2 * sizeof(struct TTEntry) <= megabytes * 1024 * 1024)
+    count *= 2;
+
+  TraceLog(LOG_DEBUG, "Allocating transposition table with %zu entries",
+           count);
+  tt->entries = (struct TTEntry *)calloc(count, sizeof(struct TTEntry));
+  if (tt->entries == NULL) {
+    TraceLog(LOG_ERROR, "Failed to allocate memory for transposition table");
+    tt->mask = 0;
+    return false;
+  }
+  tt->mask = count - 1;
+  return true;
+}
+
+void DeleteTranspositionTable(struct TranspositionTable *tt) {
+  if (tt == NULL)
+    return;
+  free(tt->entries);
+  tt->entries = NULL;
+  tt->mask = 0;
+}
+
+void ClearTranspositionTable(struct TranspositionTable *tt) {
+  if (tt != NULL && tt->entries != NULL)
+    memset(tt->entries, 0, (tt->mask + 1) * sizeof(struct TTEntry));
+}
+
+// Mate scores are stored relative to the node rather than the root, so a
+// transposition reached at another ply still reports the right distance
+static int scoreToTT(int score, int ply) {
+  if (score > MATE_BOUND)
+    return score + ply;
+  if (score < -MATE_BOUND)
+    return score - ply;
+  return score;
+}
+
+static int scoreFromTT(int score, int ply) {
+  if (score > MATE_BOUND)
+    return score - ply;
+  if (score < -MATE_BOUND)
+    return score + ply;
+  return score;
+}
+
+static struct TTEntry *probeTT(const struct Search *search, uint64_t key) {
+  if (search->tt == NULL || search->tt->entries == NULL)
+    return NULL;
+  return &search->tt->entries[key & search->tt->mask];
+}
+
+static void storeTT(struct Search *search, uint64_t key, struct Move move,
+                    int score, int depth, enum TTFlag flag, int ply) {
+  struct TTEntry *entry = probeTT(search, key);
+  if (entry == NULL)
+    return;
+
+  // Keep the old move when this node produced none of its own
+  if (IS_NULL_MOVE(move) && entry->key == key)
+    move = entry->move;
+
+  *entry = (struct TTEntry){
+      .key = key,
+      .move = move,
+      .score = (int16_t)scoreToTT(score, ply),
+      .depth = (int8_t)depth,
+      .flag = (uint8_t)flag,
+  };
+}
+
+static bool shouldStop(struct Search *search) {
+  if (atomic_load_explicit(&search->stop, memory_order_relaxed))
+    return true;
+
+  if (search->cancel != NULL &&
+      atomic_load_explicit(search->cancel, memory_order_relaxed)) {
+    atomic_store_explicit(&search->stop, true, memory_order_relaxed);
+    return true;
+  }
+
+  if ((search->nodes & 1023) != 0)
+    return false;
+
+  if ((search->limits.nodes > 0 && search->nodes >= search->limits.nodes) ||
+      (search->limits.timeMs > 0 &&
+       GetMonotonicTimeMs() - search->startMs >= search->limits.timeMs)) {
+    atomic_store_explicit(&search->stop, true, memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+static bool isExcludedRootMove(const struct Search *search,
+                               struct Move move) {
+  for (unsigned i = 0; i < search->excludedCount; i++) {
+    if (SAME_MOVE(search->excluded[i], move))
+      return true;
+  }
+  return false;
+}
+
+static void updatePV(struct Search *search, int ply, struct Move move) {
+  search->pv[ply][ply] = move;
+  for (int i = ply + 1; i < search->pvLength[ply + 1]; i++)
+    search->pv[ply][i] = search->pv[ply + 1][i];
+  search->pvLength[ply] = search->pvLength[ply + 1];
+}
+
+static int quiescence(struct Search *search, int alpha, int beta, int ply) {
+  struct Game *game = search->game;
+
+  search->pvLength[ply] = ply;
+  if (shouldStop(search))
+    return 0;
+  search->nodes++;
+
+  int best = EvaluateWith(search->evalParams, game);
+  if (ply >= MAX_PLY - 1 || best >= beta)
+    return best;
+  if (best > alpha)
+    alpha = best;
+
+  // Captures stay MVV-LVA ordered and SEE filtered even when ordering is off:
+  // an unordered quiescence search explodes and would swamp the comparison
+  struct MovePicker picker;
+  InitCapturePicker(&picker, game);
+
+  struct Move move;
+  while (NextMove(&picker, &move)) {
+    struct Undo undo;
+    int score;
+
+    MakeMove(game, move, &undo);
+    if (undo.captured->type == King) {
+      // Nothing is searched below a king capture, so the PV must end here
+      // rather than pick up a sibling's leftover line
+      if (ply + 1 < MAX_PLY)
+        search->pvLength[ply + 1] = ply + 1;
+      score = MATE_SCORE - ply - 1;
+    } else {
+      score = -quiescence(search, -beta, -alpha, ply + 1);
+    }
+    UnmakeMove(game, &undo);
+
+    if (atomic_load_explicit(&search->stop, memory_order_relaxed))
+      return 0;
+
+    if (score > best) {
+      best = score;
+      if (score > alpha) {
+        alpha = score;
+        updatePV(search, ply, move);
+        if (alpha >= beta)
+          break;
+      }
+    }
+  }
+
+  return best;
+}
+
+// Fail-soft negamax alpha-beta. The generator is pseudo-legal, so a side
+// whose king can be taken has lost: capturing the king scores as mate.
+static int negamax(struct Search *search, int depth, int alpha, int beta,
+                   int ply, struct Move previous) {
+  struct Game *game = search->game;
+
+  if (depth <= 0)
+    return quiescence(search, alpha, beta, ply);
+
+  search->pvLength[ply] = ply;
+  if (shouldStop(search))
+    return 0;
+  search->nodes++;
+
+  if (ply >= MAX_PLY - 1)
+    return EvaluateWith(search->evalParams, game);
+
+  uint64_t key = GetPositionHash(game);
+  struct Move hashMove = NULL_MOVE;
+  struct TTEntry *entry = probeTT(search, key);
+  if (entry != NULL && entry->key == key && entry->flag != TTNone) {
+    hashMove = entry->move;
+    if (ply > 0 && entry->depth >= depth) {
+      int score = scoreFromTT(entry->score, ply);
+      if (entry->flag == TTExact ||
+          (entry->flag == TTLower && score >= beta) ||
+          (entry->flag == TTUpper && score <= alpha))
+        return score;
+    }
+  }
+
+  struct MovePicker picker;
+  if (search->orderMoves)
+    InitMovePicker(&picker, game, hashMove, &search->heuristics, ply,
+                   previous);
+  else
+    InitPlainMovePicker(&picker, game);
+
+  int originalAlpha = alpha;
+  int best = -INF_SCORE;
+  struct Move bestMove = NULL_MOVE;
+  unsigned searched = 0;
+  struct Move move;
+
+  while (NextMove(&picker, &move)) {
+    struct Undo undo;
+    int score;
+
+    if (ply == 0 && isExcludedRootMove(search, move))
+      continue;
+
+    MakeMove(game, move, &undo);
+    if (undo.captured != NULL && undo.captured->type == King) {
+      if (ply + 1 < MAX_PLY)
+        search->pvLength[ply + 1] = ply + 1;
+      score = MATE_SCORE - ply - 1;
+    } else {
+      score = -negamax(search, depth - 1, -beta, -alpha, ply + 1, move);
+    }
+    UnmakeMove(game, &undo);
+    searched++;
+
+    if (atomic_load_explicit(&search->stop, memory_order_relaxed))
+      return 0;
+
+    if (score > best) {
+      best = score;
+      bestMove = move;
+      if (score > alpha) {
+        alpha = score;
+        updatePV(search, ply, move);
+        if (alpha >= beta) {
+          if (search->orderMoves && undo.captured == NULL)
+            UpdateQuietHeuristics(&search->heuristics,
+                                  GetCurrentPlayer(game), move, previous, ply,
+                                  depth);
+          break;
+        }
+      }
+    }
+  }
+
+  if (searched == 0)
+    return 0;
+
+  enum TTFlag flag = TTExact;
+  if (best >= beta)
+    flag = TTLower;
+  else if (best <= originalAlpha)
+    flag = TTUpper;
+  // A root searched with exclusions has no score of its own to share
+  if (ply > 0 || search->excludedCount == 0)
+    storeTT(search, key, bestMove, best, depth, flag, ply);
+  return best;
+}
+
+void InitSearch(struct Search *search, struct Game *game,
+                struct TranspositionTable *tt) {
+  search->game = game;
+  search->tt = tt;
+  search->orderMoves = true;
+  search->evalParams = &DefaultEvalParams;
+  search->limits = (struct SearchLimits){0};
+  search->nodes = 0;
+  search->excludedCount = 0;
+  search->cancel = NULL;
+  atomic_init(&search->stop, false);
+  ClearSearchHeuristics(&search->heuristics);
+}
+
+static void startSearch(struct Search *search,
+                        const struct SearchLimits *limits) {
+  search->limits = *limits;
+  search->nodes = 0;
+  search->startMs = GetMonotonicTimeMs();
+  atomic_store(&search->stop, false);
+}
+
+static void storeIteration(const struct Search *search, int score, int depth,
+                           struct SearchResult *result) {
+  result->score = score;
+  result->depth = depth;
+  result->pvLength = search->pvLength[0];
+  memcpy(result->pv, search->pv[0], sizeof(struct Move) * result->pvLength);
+  if (result->pvLength > 0)
+    result->bestMove = result->pv[0];
+}
+
+// Iterative deepening driver. An iteration interrupted by a limit is
+// discarded unless nothing has completed yet.
+struct SearchResult SearchPosition(struct Search *search,
+                                   const struct SearchLimits *limits) {
+  struct SearchResult result = {.bestMove = NULL_MOVE};
+  int maxDepth = limits->depth > 0 && limits->depth < SEARCH_MAX_DEPTH
+                     ? limits->depth
+                     : SEARCH_MAX_DEPTH;
+
+  startSearch(search, limits);
+  for (int depth = 1; depth <= maxDepth; depth++) {
+    int score = negamax(search, depth, -INF_SCORE, INF_SCORE, 0, NULL_MOVE);
+    bool stopped = atomic_load(&search->stop);
+
+    if (stopped && (depth > 1 || search->pvLength[0] == 0))
+      break;
+
+    storeIteration(search, score, depth, &result);
+    TraceLog(LOG_DEBUG, "Depth %d score %d nodes %lld", depth, score,
+             search->nodes);
+
+    if (stopped || score > MATE_BOUND || score < -MATE_BOUND)
+      break;
+  }
+
+  result.nodes = search->nodes;
+  result.timeMs = GetMonotonicTimeMs() - search->startMs;
+  return result;
+}
+
+// A single root iteration, for callers that run their own deepening loop.
+// Only the cancel flag can interrupt it; the result then has no best move.
+struct SearchResult SearchDepth(struct Search *search, int depth) {
+  struct SearchResult result = {.bestMove = NULL_MOVE};
+  struct SearchLimits limits = {.depth = depth};
+  if (depth < 1)
+    depth = 1;
+  if (depth > SEARCH_MAX_DEPTH)
+    depth = SEARCH_MAX_DEPTH;
+
+  startSearch(search, &limits);
+  int score = negamax(search, depth, -INF_SCORE, INF_SCORE, 0, NULL_MOVE);
+  if (!atomic_load(&search->stop))
+    storeIteration(search, score, depth, &result);
+
+  result.nodes = search->nodes;
+  result.timeMs = GetMonotonicTimeMs() - search->startMs;
+  return result;
+}
@@ -0,0 +1,86 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdatomic.h>
+
+#include "eval.h"
+#include "game.h"
+#include "movepick.h"
+
+#define MATE_SCORE 30000
+#define INF_SCORE 32000
+// Scores beyond this bound encode a king capture a known number of plies away
+#define MATE_BOUND (MATE_SCORE - MAX_PLY)
+// Deepest root iteration the fixed-size ply arrays allow
+#define SEARCH_MAX_DEPTH (MAX_PLY - 1)
+
+enum TTFlag {
+  TTNone = 0,
+  TTExact,
+  TTLower,
+  TTUpper,
+};
+
+struct TTEntry {
+  uint64_t key;
+  struct Move move;
+  int16_t score;
+  int8_t depth;
+  uint8_t flag;
+};
+
+struct TranspositionTable {
+  struct TTEntry *entries;
+  size_t mask;
+};
+
+// A zero field means "no limit"; with no depth the search runs to
+// SEARCH_MAX_DEPTH
+struct SearchLimits {
+  int depth;
+  long long nodes;
+  long long timeMs;
+};
+
+struct SearchResult {
+  struct Move bestMove;
+  int score;
+  int depth;
+  long long nodes;
+  long long timeMs;
+  struct Move pv[MAX_PLY];
+  int pvLength;
+};
+
+struct Search {
+  struct Game *game;
+  struct TranspositionTable *tt;
+  struct SearchHeuristics heuristics;
+  struct SearchLimits limits;
+  // Off: moves are searched in raw generation order, for measurement only
+  bool orderMoves;
+  const struct EvalParams *evalParams;
+  // Root moves to skip, so repeated searches can find the next best line
+  struct Move excluded[MAX_MOVES];
+  unsigned excludedCount;
+  // Optional flag owned by another thread that aborts the search
+  atomic_bool *cancel;
+  atomic_bool stop;
+  long long nodes;
+  long long startMs;
+  struct Move pv[MAX_PLY][MAX_PLY];
+  int pvLength[MAX_PLY];
+};
+
+bool NewTranspositionTable(struct TranspositionTable *tt, size_t megabytes);
+void DeleteTranspositionTable(struct TranspositionTable *tt);
+void ClearTranspositionTable(struct TranspositionTable *tt);
+
+void InitSearch(struct Search *search, struct Game *game,
+                struct TranspositionTable *tt);
+struct SearchResult SearchPosition(struct Search *search,
+                                   const struct SearchLimits *limits);
+struct SearchResult SearchDepth(struct Search *search, int depth);
+long long GetMonotonicTimeMs();
+
+#endif // SEARCH_H
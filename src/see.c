@@ -0,0 +1,145 @@
+#include "see.h"
+
+const int SeeValue[6] = {
+    [Pawn] = 100, [Knight] = 320, [Bishop] = 330,
+    [King] = 20000, [Rook] = 500, [Queen] = 900,
+};
+
+static const int knightOffsets[8][2] = {
+    {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2},
+};
+
+static const int diagonalOffsets[4][2] = {{-1, 1}, {1, 1}, {-1, -1}, {1, -1}};
+
+static const int straightOffsets[4][2] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
+
+static void copyBoard(const struct Game *game, const struct Piece *board[64]) {
+  for (int x = 0; x < 8; x++) {
+    for (int y = 0; y < 8; y++) {
+      board[SQUARE_INDEX(x, y)] = game->board->pieces[x][y];
+    }
+  }
+}
+
+static void considerAttacker(const struct Piece *const board[64], int x, int y,
+                             enum Player by, unsigned typeMask, int *best) {
+  if (x < 0 || x >= 8 || y < 0 || y >= 8)
+    return;
+
+  const struct Piece *p = board[SQUARE_INDEX(x, y)];
+  if (p == NULL || p->player != by || !(typeMask & (1u << p->type)))
+    return;
+
+  if (*best < 0 || SeeValue[p->type] < SeeValue[board[*best]->type])
+    *best = SQUARE_INDEX(x, y);
+}
+
+// Returns the square of the cheapest piece of `by` attacking `square`, or
+// -1. Sliders are found by walking out from the target, so removing a piece
+// from the board uncovers any x-ray attacker behind it.
+static int leastValuableAttacker(const struct Piece *const board[64],
+                                 int square, enum Player by) {
+  int x = SQUARE_X(square);
+  int y = SQUARE_Y(square);
+  int best = -1;
+
+  // White pawns move towards y = 0, so they attack from the row below
+  int pawnY = y + (by == WhitePlayer ? 1 : -1);
+  considerAttacker(board, x - 1, pawnY, by, 1u << Pawn, &best);
+  considerAttacker(board, x + 1, pawnY, by, 1u << Pawn, &best);
+
+  for (int i = 0; i < 8; i++) {
+    considerAttacker(board, x + knightOffsets[i][0], y + knightOffsets[i][1],
+                     by, 1u << Knight, &best);
+  }
+
+  for (int d = 0; d < 4; d++) {
+    for (int pass = 0; pass < 2; pass++) {
+      const int(*offsets)[2] = pass == 0 ? diagonalOffsets : straightOffsets;
+      unsigned sliders = pass == 0 ? (1u << Bishop) | (1u << Queen)
+                                   : (1u << Rook) | (1u << Queen);
+      int dx = offsets[d][0], dy = offsets[d][1];
+
+      considerAttacker(board, x + dx, y + dy, by, 1u << King, &best);
+      for (int nx = x + dx, ny = y + dy; nx >= 0 && nx < 8 && ny >= 0 && ny < 8;
+           nx += dx, ny += dy) {
+        if (board[SQUARE_INDEX(nx, ny)] != NULL) {
+          considerAttacker(board, nx, ny, by, sliders, &best);
+          break;
+        }
+      }
+    }
+  }
+
+  return best;
+}
+
+bool IsSquareAttacked(const struct Game *game, int square, enum Player by) {
+  const struct Piece *board[64];
+  copyBoard(game, board);
+  return leastValuableAttacker(board, square, by) >= 0;
+}
+
+// A side without a king (captured in a pseudo-legal line) is not in check
+bool IsInCheck(const struct Game *game, enum Player player) {
+  const struct Piece *board[64];
+  copyBoard(game, board);
+
+  for (int square = 0; square < 64; square++) {
+    const struct Piece *p = board[square];
+    if (p != NULL && p->type == King && p->player == player) {
+      enum Player by = player == WhitePlayer ? BlackPlayer : WhitePlayer;
+      return leastValuableAttacker(board, square, by) >= 0;
+    }
+  }
+  return false;
+}
+
+// Swap-list exchange evaluation: both sides keep recapturing on the target
+// square with their cheapest attacker and may stop whenever continuing
+// would lose material. Returns the material balance for the moving side.
+int StaticExchangeEvaluation(const struct Game *game, struct Move move) {
+  const struct Piece *board[64];
+  int gain[32];
+  int depth = 0;
+
+  copyBoard(game, board);
+  const struct Piece *mover = board[move.from];
+  if (mover == NULL)
+    return 0;
+
+  gain[0] = board[move.to] != NULL ? SeeValue[board[move.to]->type] : 0;
+  int onSquare = SeeValue[mover->type];
+  board[move.to] = mover;
+  board[move.from] = NULL;
+  enum Player side = mover->player == WhitePlayer ? BlackPlayer : WhitePlayer;
+
+  while (depth < 31) {
+    int from = leastValuableAttacker(board, move.to, side);
+    if (from < 0)
+      break;
+
+    // Both standing pat and recapturing lose, the sign is already settled
+    int speculative = onSquare - gain[depth];
+    if (gain[depth] > 0 && speculative < 0)
+      break;
+    gain[++depth] = speculative;
+
+    onSquare = SeeValue[board[from]->type];
+    board[move.to] = board[from];
+    board[from] = NULL;
+    side = side == WhitePlayer ? BlackPlayer : WhitePlayer;
+  }
+
+  while (depth > 0) {
+    depth--;
+    int standPat = -gain[depth];
+    gain[depth] = -(standPat > gain[depth + 1] ? standPat : gain[depth + 1]);
+  }
+
+  return gain[0];
+}
+
+bool SeeAtLeast(const struct Game *game, struct Move move, int threshold) {
+  return StaticExchangeEvaluation(game, move) >= threshold;
+}
@@ -0,0 +1,15 @@
+#ifndef SEE_H
+#define SEE_H
+
+#include "game.h"
+
+// Exchange values, indexed by enum PieceType. The king is priced so that
+// losing it outweighs any material swing.
+extern const int SeeValue[6];
+
+bool IsSquareAttacked(const struct Game *game, int square, enum Player by);
+bool IsInCheck(const struct Game *game, enum Player player);
+int StaticExchangeEvaluation(const struct Game *game, struct Move move);
+bool SeeAtLeast(const struct Game *game, struct Move move, int threshold);
+
+#endif // SEE_H
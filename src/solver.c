@@ -0,0 +1,176 @@
+// Mate-in-N solver and problem suite.
+//
+// Usage: ./solver solve [--hash MB] [--nodes N] FEN moves
+//        ./solver suite [--hash MB] [--nodes N]
+//
+// `solve` looks for a mate by the side to move in at most `moves` moves and
+// prints the line, or reports that none exists. `suite` runs the mate
+// problems from positions.c and reports each solve time, failing if any
+// answer differs from the expected mate length.
+//
+// --hash sizes the proof table in MB and must be at least 1: df-pn leans on
+// its table, and a smaller one thrashes until even short mates take minutes.
+
+#include <string.h>
+
+#include "mate.h"
+#include "pgn.h"
+#include "positions.h"
+
+#define DEFAULT_HASH_MB 64
+
+struct SolverOptions {
+  size_t hashMb;
+  long long maxNodes;
+};
+
+// Consumes leading options; returns the index of the first argument left
+static int parseOptions(int argc, char **argv, struct SolverOptions *options) {
+  int i = 0;
+  while (i + 1 < argc && strncmp(argv[i], "--", 2) == 0) {
+    if (strcmp(argv[i], "--hash") == 0) {
+      long megabytes = atol(argv[i + 1]);
+      if (megabytes < 1)
+        return -1;
+      options->hashMb = (size_t)megabytes;
+    } else if (strcmp(argv[i], "--nodes") == 0) {
+      options->maxNodes = atoll(argv[i + 1]);
+    } else {
+      return -1;
+    }
+    i += 2;
+  }
+  return i;
+}
+
+// Prints the line as numbered SAN, replaying it on the game and restoring
+// the starting position afterwards
+static void printLine(struct Game *game, const struct MateResult *result) {
+  struct Undo undo[MATE_MAX_LINE];
+  char san[16];
+
+  // Counting plies from white's first move keeps numbers right whichever
+  // side starts the line
+  int offset = GetCurrentPlayer(game) == WhitePlayer ? 0 : 1;
+  for (int i = 0; i < result->lineLength; i++) {
+    int ply = i + offset;
+    if (ply % 2 == 0)
+      printf("%d. ", ply / 2 + 1);
+    else if (i == 0)
+      printf("%d... ", ply / 2 + 1);
+    FormatSAN(game, result->line[i], san, sizeof(san));
+    printf("%s%s", san, i + 1 < result->lineLength ? " " : "#\n");
+    MakeMove(game, result->line[i], &undo[i]);
+  }
+  for (int i = result->lineLength - 1; i >= 0; i--)
+    UnmakeMove(game, &undo[i]);
+}
+
+static int solve(int argc, char **argv) {
+  struct SolverOptions options = {DEFAULT_HASH_MB, 0};
+  int first = parseOptions(argc, argv, &options);
+  if (first < 0 || argc - first != 2) {
+    fprintf(stderr,
+            "Usage: solver solve [--hash MB] [--nodes N] FEN moves\n");
+    return 1;
+  }
+  int maxMoves = atoi(argv[first + 1]);
+  if (maxMoves <= 0 || maxMoves > MATE_MAX_MOVES) {
+    fprintf(stderr, "Mate length must be between 1 and %d\n",
+            MATE_MAX_MOVES);
+    return 1;
+  }
+
+  struct Game *game = NewGame();
+  struct MateTable table;
+  if (game == NULL || !NewMateTable(&table, options.hashMb)) {
+    fprintf(stderr, "Failed to allocate solver state\n");
+    return 1;
+  }
+  if (!LoadFEN(game, argv[first])) {
+    fprintf(stderr, "Invalid FEN '%s'\n", argv[first]);
+    return 1;
+  }
+
+  struct MateResult result =
+      SolveMate(game, &table, maxMoves, options.maxNodes);
+  if (result.outcome == MateProven) {
+    printf("mate in %d\n", result.moves);
+    printLine(game, &result);
+  } else if (result.outcome == MateDisproven) {
+    printf("no mate in %d\n", result.moves);
+  } else if (result.outcome == MateIllegal) {
+    fprintf(stderr, "Illegal position: the side not to move is in check\n");
+  } else {
+    printf("unresolved after %lld nodes\n", result.nodes);
+  }
+  if (result.outcome != MateIllegal)
+    printf("%lld nodes, %lld ms\n", result.nodes, result.timeMs);
+
+  DeleteMateTable(&table);
+  DeleteGame(game);
+  return result.outcome == MateUnresolved || result.outcome == MateIllegal;
+}
+
+static int suite(int argc, char **argv) {
+  struct SolverOptions options = {DEFAULT_HASH_MB, 0};
+  if (parseOptions(argc, argv, &options) != argc) {
+    fprintf(stderr, "Usage: solver suite [--hash MB] [--nodes N]\n");
+    return 1;
+  }
+
+  struct Game *game = NewGame();
+  struct MateTable table;
+  if (game == NULL || !NewMateTable(&table, options.hashMb)) {
+    fprintf(stderr, "Failed to allocate solver state\n");
+    return 1;
+  }
+
+  long long totalNodes = 0, totalMs = 0;
+  unsigned failures = 0;
+  printf("%-4s %-6s %-8s %12s %9s\n", "pos", "limit", "found", "nodes",
+         "ms");
+  for (unsigned i = 0; i < MateProblemCount; i++) {
+    const struct MateProblem *problem = &MateProblems[i];
+    if (!LoadFEN(game, problem->fen))
+      return 1;
+
+    ClearMateTable(&table);
+    struct MateResult result =
+        SolveMate(game, &table, problem->limit, options.maxNodes);
+    totalNodes += result.nodes;
+    totalMs += result.timeMs;
+
+    char found[16] = "none";
+    if (result.outcome == MateProven)
+      snprintf(found, sizeof(found), "#%d", result.moves);
+    else if (result.outcome == MateUnresolved)
+      snprintf(found, sizeof(found), "?");
+    else if (result.outcome == MateIllegal)
+      snprintf(found, sizeof(found), "illegal");
+
+    bool expected = result.outcome == MateDisproven && problem->mate == 0;
+    if (result.outcome == MateProven)
+      expected = result.moves == problem->mate;
+    failures += !expected;
+    printf("%-4u %-6d %-8s %12lld %9lld%s\n", i, problem->limit, found,
+           result.nodes, result.timeMs, expected ? "" : "  FAILED");
+  }
+  printf("%-4s %-6s %-8s %12lld %9lld\n", "all", "", "", totalNodes,
+         totalMs);
+
+  DeleteMateTable(&table);
+  DeleteGame(game);
+  return failures > 0;
+}
+
+int main(int argc, char **argv) {
+  SetTraceLogLevel(LOG_WARNING);
+  if (argc >= 2 && strcmp(argv[1], "solve") == 0)
+    return solve(argc - 2, argv + 2);
+  if (argc >= 2 && strcmp(argv[1], "suite") == 0)
+    return suite(argc - 2, argv + 2);
+
+  fprintf(stderr, "Usage: %s solve|suite ...\n", argv[0]);
+  return 1;
+}
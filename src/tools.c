@@ -0,0 +1,30 @@
+#include "tools.h"
+
+#include <time.h>
+
+long long GetMonotonicTimeNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+bool IsRepetition(const uint64_t *history, int ply) {
+  unsigned seen = 0;
+  for (int i = ply - 2; i >= 0; i -= 2) {
+    if (history[i] == history[ply] && ++seen >= 2)
+      return true;
+  }
+  return false;
+}
+
+bool UpdateResignTracker(struct ResignTracker *tracker, int whiteScore) {
+  if (abs(whiteScore) >= RESIGN_SCORE) {
+    bool sameWinner = tracker->count > 0 &&
+                      (whiteScore > 0) == (tracker->lastWhiteScore > 0);
+    tracker->count = sameWinner ? tracker->count + 1 : 1;
+  } else {
+    tracker->count = 0;
+  }
+  tracker->lastWhiteScore = whiteScore;
+  return tracker->count >= RESIGN_PLIES;
+}
@@ -0,0 +1,27 @@
+#ifndef TOOLS_H
+#define TOOLS_H
+
+#include "game.h"
+
+// Adjudication shared by the tools that play engine games: a side is lost
+// once the searches agree on a decisive score for a few consecutive plies
+#define RESIGN_SCORE 1000
+#define RESIGN_PLIES 4
+
+struct ResignTracker {
+  int count;
+  int lastWhiteScore;
+};
+
+long long GetMonotonicTimeNs();
+
+// True when the position at `ply` already occurred twice with the same side
+// to move. `history` holds the position hash after every ply.
+bool IsRepetition(const uint64_t *history, int ply);
+
+// Feeds the score of the move just searched, from white's point of view.
+// Returns true once the streak is long enough to resign; the sign of
+// `whiteScore` then tells who won.
+bool UpdateResignTracker(struct ResignTracker *tracker, int whiteScore);
+
+#endif // TOOLS_H
@@ -0,0 +1,460 @@
+// Headless engine-vs-engine tournament with SPRT early stopping.
+//
+// Usage: ./tournament [--games N] [--concurrency N] [--openings file]
+//                     [--tc base+inc] [--sprt elo0,elo1]
+//                     [--engine-a spec] [--engine-b spec]
+//
+// An engine spec is a comma separated list of key=value pairs: depth, nodes,
+// hash (MB), ordering (0/1) and eval (a parameter file from ./tuner). Times
+// are in milliseconds. Every opening is played twice with colours reversed.
+//
+// Clocks run on wall-clock time, so every game needs a core of its own:
+// --concurrency is capped at the number of online cores, since games sharing
+// a core would lose on time to scheduler noise.
+
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "search.h"
+#include "tools.h"
+
+#define MAX_OPENINGS 4096
+#define MAX_GAME_PLIES 400
+#define SPRT_ALPHA 0.05
+#define SPRT_BETA 0.05
+
+// Adjudication: besides resignation (see tools.h), a long quiet stretch late
+// in the game is drawn
+#define DRAW_SCORE 10
+#define DRAW_PLIES 12
+#define DRAW_MIN_PLY 80
+
+enum GameResult {
+  ResultWhiteWins = 0,
+  ResultDraw,
+  ResultBlackWins,
+};
+
+struct EngineConfig {
+  int depth;
+  long long nodes;
+  size_t hashMb;
+  bool orderMoves;
+  // NULL for the built-in evaluation
+  struct EvalParams *evalParams;
+};
+
+struct Tournament {
+  const char *openings[MAX_OPENINGS];
+  unsigned openingCount;
+  unsigned games;
+  unsigned concurrency;
+  long long baseMs;
+  long long incrementMs;
+  double elo0, elo1;
+  struct EngineConfig engines[2];
+
+  atomic_uint nextGame;
+  atomic_bool stop;
+
+  pthread_mutex_t lock;
+  unsigned wins, draws, losses; // from engine A's point of view
+  unsigned timeLosses, adjudicated;
+  double llr;
+};
+
+static const char *const defaultOpenings[] = {
+    "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w - - 0 2",
+    "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w - - 0 2",
+    "rnbqkbnr/ppp1pppp/8/3p4/3P4/8/PPP1PPPP/RNBQKBNR w - - 0 2",
+    "rnbqkb1r/pppppppp/5n2/8/2P5/8/PP1PPPPP/RNBQKBNR w - - 1 2",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w - - 2 3",
+    "rnbqkbnr/pppp1ppp/4p3/8/3PP3/8/PPP2PPP/RNBQKBNR b - - 0 2",
+    "rnbqkbnr/pp2pppp/2p5/3p4/2PP4/8/PP2PPPP/RNBQKBNR w - - 0 3",
+    "rnbqkb1r/pppp1ppp/4pn2/8/2PP4/8/PP2PPPP/RNBQKBNR w - - 0 3",
+};
+
+static double scoreFromElo(double elo) {
+  return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+// Trinomial log-likelihood ratio of elo1 against elo0, using the normal
+// approximation from the observed score variance
+static double computeLLR(unsigned wins, unsigned draws, unsigned losses,
+                         double elo0, double elo1) {
+  double n = wins + draws + losses;
+  if (n == 0)
+    return 0.0;
+
+  double score = (wins + 0.5 * draws) / n;
+  double variance = (wins * pow(1.0 - score, 2) +
+                     draws * pow(0.5 - score, 2) + losses * pow(score, 2)) /
+                    n;
+  if (variance <= 0.0)
+    return 0.0;
+  double s0 = scoreFromElo(elo0);
+  double s1 = scoreFromElo(elo1);
+  return n * (s1 - s0) * (2.0 * score - s0 - s1) / (2.0 * variance);
+}
+
+// Only finite for scores strictly between 0 and 1
+static double eloFromScore(double score) {
+  return -400.0 * log10(1.0 / score - 1.0);
+}
+
+static bool parseEngineConfig(const char *spec, struct EngineConfig *config) {
+  char buffer[256];
+  snprintf(buffer, sizeof(buffer), "%s", spec);
+
+  for (char *token = strtok(buffer, ","); token != NULL;
+       token = strtok(NULL, ",")) {
+    char *value = strchr(token, '=');
+    if (value == NULL)
+      return false;
+    *value++ = '\0';
+
+    if (strcmp(token, "depth") == 0)
+      config->depth = atoi(value);
+    else if (strcmp(token, "nodes") == 0)
+      config->nodes = atoll(value);
+    else if (strcmp(token, "hash") == 0)
+      config->hashMb = (size_t)atoll(value);
+    else if (strcmp(token, "ordering") == 0)
+      config->orderMoves = atoi(value) != 0;
+    else if (strcmp(token, "eval") == 0) {
+      free(config->evalParams);
+      config->evalParams =
+          (struct EvalParams *)malloc(sizeof(struct EvalParams));
+      if (config->evalParams == NULL ||
+          !LoadEvalParams(config->evalParams, value))
+        return false;
+    } else
+      return false;
+  }
+  return true;
+}
+
+static bool loadOpenings(struct Tournament *t, const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "Failed to open openings file '%s'\n", path);
+    return false;
+  }
+
+  // Every FEN is tried now: a bad one would otherwise only fail inside a
+  // worker, losing its games without a word
+  struct Game *game = NewGame();
+  if (game == NULL) {
+    fclose(file);
+    return false;
+  }
+
+  char line[256];
+  unsigned lineNumber = 0;
+  bool ok = true;
+  while (ok && t->openingCount < MAX_OPENINGS &&
+         fgets(line, sizeof(line), file)) {
+    lineNumber++;
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0' || line[0] == '#')
+      continue;
+    ok = LoadFEN(game, line);
+    if (ok)
+      t->openings[t->openingCount++] = strdup(line);
+    else
+      fprintf(stderr, "Invalid FEN on line %u of '%s'\n", lineNumber, path);
+  }
+  DeleteGame(game);
+  fclose(file);
+  return ok && t->openingCount > 0;
+}
+
+// Plays one game between the two searches. `white` is 0 when engine A has
+// the white pieces. Returns false if the tournament was stopped mid-game.
+static bool playGame(struct Tournament *t, struct Game *game,
+                     struct Search *searches[2], const char *opening,
+                     int white, enum GameResult *result, bool *onTime,
+                     bool *wasAdjudicated) {
+  uint64_t hashes[MAX_GAME_PLIES + 1];
+  long long clocks[2] = {t->baseMs, t->baseMs};
+  struct ResignTracker resign = {0};
+  int drawCount = 0;
+
+  if (!LoadFEN(game, opening))
+    return false;
+  for (int i = 0; i < 2; i++) {
+    ClearTranspositionTable(searches[i]->tt);
+    ClearSearchHeuristics(&searches[i]->heuristics);
+  }
+
+  *onTime = false;
+  *wasAdjudicated = false;
+  *result = ResultDraw;
+  hashes[0] = GetPositionHash(game);
+
+  for (int ply = 0; ply < MAX_GAME_PLIES; ply++) {
+    if (atomic_load(&t->stop))
+      return false;
+
+    enum Player side = GetCurrentPlayer(game);
+    int engine = (side == WhitePlayer) ? white : 1 - white;
+    const struct EngineConfig *config = &t->engines[engine];
+
+    struct SearchLimits limits = {
+        .depth = config->depth,
+        .nodes = config->nodes,
+        .timeMs = clocks[engine] / 20 + t->incrementMs * 3 / 4,
+    };
+    if (limits.timeMs < 1)
+      limits.timeMs = 1;
+
+    long long start = GetMonotonicTimeMs();
+    struct SearchResult found = SearchPosition(searches[engine], &limits);
+    clocks[engine] -= GetMonotonicTimeMs() - start;
+
+    enum GameResult sideWins =
+        side == WhitePlayer ? ResultWhiteWins : ResultBlackWins;
+    enum GameResult sideLoses =
+        side == WhitePlayer ? ResultBlackWins : ResultWhiteWins;
+
+    if (clocks[engine] < 0) {
+      *result = sideLoses;
+      *onTime = true;
+      return true;
+    }
+    clocks[engine] += t->incrementMs;
+
+    if (IS_NULL_MOVE(found.bestMove))
+      return true;
+
+    // Consecutive plies come from different engines, so a streak means both
+    // agree on who is winning
+    int whiteScore = side == WhitePlayer ? found.score : -found.score;
+    bool resigned = UpdateResignTracker(&resign, whiteScore);
+
+    drawCount = (ply >= DRAW_MIN_PLY && abs(whiteScore) <= DRAW_SCORE)
+                    ? drawCount + 1
+                    : 0;
+
+    if (resigned || drawCount >= DRAW_PLIES) {
+      *wasAdjudicated = true;
+      if (resigned)
+        *result = whiteScore > 0 ? ResultWhiteWins : ResultBlackWins;
+      return true;
+    }
+
+    struct Undo undo;
+    MakeMove(game, found.bestMove, &undo);
+    if (undo.captured != NULL && undo.captured->type == King) {
+      *result = sideWins;
+      return true;
+    }
+
+    hashes[ply + 1] = GetPositionHash(game);
+    if (IsRepetition(hashes, ply + 1))
+      return true;
+  }
+
+  return true;
+}
+
+static void recordResult(struct Tournament *t, enum GameResult result,
+                         int white, bool onTime, bool wasAdjudicated) {
+  pthread_mutex_lock(&t->lock);
+
+  if (result == ResultDraw)
+    t->draws++;
+  else if ((result == ResultWhiteWins) == (white == 0))
+    t->wins++;
+  else
+    t->losses++;
+  t->timeLosses += onTime;
+  t->adjudicated += wasAdjudicated;
+
+  unsigned played = t->wins + t->draws + t->losses;
+  double score = (t->wins + 0.5 * t->draws) / played;
+  t->llr = computeLLR(t->wins, t->draws, t->losses, t->elo0, t->elo1);
+
+  double lower = log(SPRT_BETA / (1.0 - SPRT_ALPHA));
+  double upper = log((1.0 - SPRT_BETA) / SPRT_ALPHA);
+  char elo[16] = "n/a";
+  if (score > 0.0 && score < 1.0)
+    snprintf(elo, sizeof(elo), "%+.1f", eloFromScore(score));
+  printf("game %u: +%u =%u -%u  elo %s  LLR %.2f [%.2f, %.2f]\n", played,
+         t->wins, t->draws, t->losses, elo, t->llr, lower, upper);
+  fflush(stdout);
+
+  if (t->llr <= lower || t->llr >= upper)
+    atomic_store(&t->stop, true);
+
+  pthread_mutex_unlock(&t->lock);
+}
+
+static void *worker(void *arg) {
+  struct Tournament *t = (struct Tournament *)arg;
+  struct Game *game = NewGame();
+  // Zeroed so tables that were never created are safe to delete
+  struct TranspositionTable tables[2] = {{0}};
+  struct Search *searches[2] = {NULL, NULL};
+  bool ready = game != NULL;
+
+  for (int i = 0; i < 2; i++) {
+    searches[i] = (struct Search *)malloc(sizeof(struct Search));
+    ready = ready && searches[i] != NULL &&
+            NewTranspositionTable(&tables[i], t->engines[i].hashMb);
+    if (searches[i] != NULL) {
+      InitSearch(searches[i], game, &tables[i]);
+      searches[i]->orderMoves = t->engines[i].orderMoves;
+      if (t->engines[i].evalParams != NULL)
+        searches[i]->evalParams = t->engines[i].evalParams;
+    }
+  }
+
+  while (ready && !atomic_load(&t->stop)) {
+    unsigned index = atomic_fetch_add(&t->nextGame, 1);
+    if (index >= t->games)
+      break;
+
+    const char *opening = t->openings[(index / 2) % t->openingCount];
+    int white = index % 2;
+    enum GameResult result;
+    bool onTime, wasAdjudicated;
+
+    if (playGame(t, game, searches, opening, white, &result, &onTime,
+                 &wasAdjudicated))
+      recordResult(t, result, white, onTime, wasAdjudicated);
+  }
+
+  for (int i = 0; i < 2; i++) {
+    DeleteTranspositionTable(&tables[i]);
+    free(searches[i]);
+  }
+  DeleteGame(game);
+  return NULL;
+}
+
+int main(int argc, char **argv) {
+  static struct Tournament t = {
+      .games = 1000,
+      .baseMs = 2000,
+      .incrementMs = 20,
+      .elo0 = 0.0,
+      .elo1 = 5.0,
+      .engines =
+          {
+              {.hashMb = 16, .orderMoves = true},
+              {.hashMb = 16, .orderMoves = true},
+          },
+  };
+  unsigned cores = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+  t.concurrency = cores;
+
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 == argc) {
+      fprintf(stderr, "Option '%s' needs a value\n", argv[i]);
+      return 1;
+    }
+    const char *value = argv[i + 1];
+    bool ok = true;
+
+    if (strcmp(argv[i], "--games") == 0)
+      t.games = (unsigned)atoi(value);
+    else if (strcmp(argv[i], "--concurrency") == 0)
+      t.concurrency = (unsigned)atoi(value);
+    else if (strcmp(argv[i], "--openings") == 0)
+      ok = loadOpenings(&t, value);
+    else if (strcmp(argv[i], "--tc") == 0)
+      ok = sscanf(value, "%lld+%lld", &t.baseMs, &t.incrementMs) == 2;
+    else if (strcmp(argv[i], "--sprt") == 0)
+      ok = sscanf(value, "%lf,%lf", &t.elo0, &t.elo1) == 2;
+    else if (strcmp(argv[i], "--engine-a") == 0)
+      ok = parseEngineConfig(value, &t.engines[0]);
+    else if (strcmp(argv[i], "--engine-b") == 0)
+      ok = parseEngineConfig(value, &t.engines[1]);
+    else
+      ok = false;
+
+    if (!ok) {
+      fprintf(stderr, "Invalid option '%s %s'\n", argv[i], value);
+      return 1;
+    }
+  }
+
+  if (t.openingCount == 0) {
+    for (unsigned i = 0;
+         i < sizeof(defaultOpenings) / sizeof(defaultOpenings[0]); i++)
+      t.openings[t.openingCount++] = defaultOpenings[i];
+  }
+  if (t.concurrency == 0)
+    t.concurrency = 1;
+  if (cores > 0 && t.concurrency > cores) {
+    fprintf(stderr,
+            "Capping concurrency at %u online cores: the clocks measure "
+            "wall-clock time\n",
+            cores);
+    t.concurrency = cores;
+  }
+
+  SetTraceLogLevel(LOG_WARNING);
+  pthread_mutex_init(&t.lock, NULL);
+  atomic_init(&t.nextGame, 0);
+  atomic_init(&t.stop, false);
+
+  printf("%u games, %u threads, tc %lld+%lld ms, SPRT elo0=%.1f elo1=%.1f\n",
+         t.games, t.concurrency, t.baseMs, t.incrementMs, t.elo0, t.elo1);
+
+  pthread_t *threads = (pthread_t *)malloc(t.concurrency * sizeof(pthread_t));
+  if (threads == NULL) {
+    fprintf(stderr, "Failed to allocate worker threads\n");
+    return 1;
+  }
+
+  // Workers share the game counter, so the ones that start play every game
+  long long start = GetMonotonicTimeMs();
+  unsigned started = 0;
+  while (started < t.concurrency &&
+         pthread_create(&threads[started], NULL, worker, &t) == 0)
+    started++;
+  if (started < t.concurrency)
+    fprintf(stderr, "Started %u of %u worker threads\n", started,
+            t.concurrency);
+  for (unsigned i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+  double wallSeconds = (GetMonotonicTimeMs() - start) / 1000.0;
+  if (started == 0) {
+    free(threads);
+    pthread_mutex_destroy(&t.lock);
+    return 1;
+  }
+  t.concurrency = started;
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  double cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                      usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+
+  unsigned played = t.wins + t.draws + t.losses;
+  const char *verdict = "inconclusive";
+  if (t.llr >= log((1.0 - SPRT_BETA) / SPRT_ALPHA))
+    verdict = "H1 accepted (engine A is stronger)";
+  else if (t.llr <= log(SPRT_BETA / (1.0 - SPRT_ALPHA)))
+    verdict = "H0 accepted";
+
+  printf("\nresult: +%u =%u -%u of %u games, %u adjudicated, %u lost on "
+         "time\n",
+         t.wins, t.draws, t.losses, played, t.adjudicated, t.timeLosses);
+  printf("SPRT: LLR %.2f, %s\n", t.llr, verdict);
+  printf("throughput: %.0f games/hour over %.1f s\n",
+         wallSeconds > 0 ? played * 3600.0 / wallSeconds : 0.0, wallSeconds);
+  printf("CPU utilisation: %.0f%% of %u threads\n",
+         wallSeconds > 0 ? 100.0 * cpuSeconds / (wallSeconds * t.concurrency)
+                         : 0.0,
+         t.concurrency);
+
+  free(threads);
+  pthread_mutex_destroy(&t.lock);
+  return 0;
+}
@@ -0,0 +1,417 @@
+// Texel-style evaluation tuner over packed training data.
+//
+// Usage: ./tuner [--threads N] [--epochs N] [--rate R] [--k K]
+//                [--init params] [--output params] [--scaling] data...
+//
+// Fits material and piece-square values so that a sigmoid of the static
+// evaluation predicts the game results in the data (mean squared error),
+// using full-batch gradient descent with Adam. The data files are mapped,
+// not loaded, and cut into fixed blocks; each block's loss and gradient go
+// to their own slot and are summed in block order, so the result is the
+// same bit for bit whatever the thread count. --scaling times one gradient
+// pass at 1, 2, 4... threads and checks exactly that.
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "eval.h"
+#include "packed.h"
+#include "tools.h"
+
+#define MAX_DATA_FILES 64
+#define BLOCK_POSITIONS 16384
+// Material values first, then the six piece-square tables
+#define PARAM_COUNT (6 + 6 * 64)
+#define PST_PARAM(type, index) (6 + (type) * 64 + (index))
+#define ADAM_BETA1 0.9
+#define ADAM_BETA2 0.999
+#define ADAM_EPSILON 1e-8
+
+struct Block {
+  const struct PackedPosition *positions;
+  unsigned count;
+};
+
+struct Tuner {
+  struct Block *blocks;
+  unsigned blockCount;
+  size_t positionCount;
+  unsigned threads;
+
+  double params[PARAM_COUNT];
+  // Sigmoid slope per centipawn: predicted score = 1 / (1 + e^(-k * eval))
+  double k;
+
+  bool withGradient;
+  atomic_uint nextBlock;
+  double *blockLoss;
+  double *blockGradient;
+};
+
+// Per-thread scratch for the dense part of a block
+struct TunerWorker {
+  struct Tuner *tuner;
+  double evals[BLOCK_POSITIONS];
+  double targets[BLOCK_POSITIONS];
+  double weights[BLOCK_POSITIONS];
+};
+
+// Calls `visit` for every piece with its material and table parameters and
+// +1 for white or -1 for black. The evaluation is linear in the parameters,
+// so these are also the gradient coefficients.
+#define FOR_EACH_FEATURE(position, visit)                                      \
+  do {                                                                         \
+    uint64_t occupied = (position)->occupancy;                                 \
+    for (unsigned n = 0; occupied != 0; n++, occupied &= occupied - 1) {       \
+      int square = __builtin_ctzll(occupied);                                  \
+      unsigned code = ((position)->pieces[n / 2] >> (4 * (n % 2))) & 15;       \
+      unsigned type = code % 6;                                                \
+      enum Player player = code < 6 ? WhitePlayer : BlackPlayer;               \
+      int table = PST_INDEX(player, SQUARE_X(square), SQUARE_Y(square));       \
+      double sign = player == WhitePlayer ? 1.0 : -1.0;                        \
+      visit(type, PST_PARAM(type, table), sign);                               \
+    }                                                                          \
+  } while (0)
+
+static void processBlock(struct TunerWorker *w, unsigned b) {
+  struct Tuner *t = w->tuner;
+  const struct Block *block = &t->blocks[b];
+  const double *params = t->params;
+  double k = t->k;
+
+  // Sparse pass: evaluation from white's point of view and the result
+  for (unsigned i = 0; i < block->count; i++) {
+    double eval = 0.0;
+#define ADD_VALUE(material, table, sign)                                       \
+  eval += (sign) * (params[material] + params[table])
+    FOR_EACH_FEATURE(&block->positions[i], ADD_VALUE);
+#undef ADD_VALUE
+    w->evals[i] = eval;
+    w->targets[i] = block->positions[i].result * 0.5;
+  }
+
+  // Dense pass: straight-line arithmetic over arrays, which the compiler
+  // turns into vector code
+  const double *evals = w->evals, *targets = w->targets;
+  double *weights = w->weights;
+  double loss = 0.0;
+  for (unsigned i = 0; i < block->count; i++) {
+    double predicted = 1.0 / (1.0 + exp(-k * evals[i]));
+    double error = targets[i] - predicted;
+    loss += error * error;
+    weights[i] = -2.0 * k * error * predicted * (1.0 - predicted);
+  }
+  t->blockLoss[b] = loss;
+
+  if (!t->withGradient)
+    return;
+  double *gradient = &t->blockGradient[(size_t)b * PARAM_COUNT];
+  memset(gradient, 0, PARAM_COUNT * sizeof(double));
+  for (unsigned i = 0; i < block->count; i++) {
+    double weight = w->weights[i];
+#define ADD_GRADIENT(material, table, sign)                                    \
+  do {                                                                         \
+    gradient[material] += (sign) * weight;                                     \
+    gradient[table] += (sign) * weight;                                        \
+  } while (0)
+    FOR_EACH_FEATURE(&block->positions[i], ADD_GRADIENT);
+#undef ADD_GRADIENT
+  }
+}
+
+static void *tunerWorker(void *arg) {
+  struct TunerWorker *w = (struct TunerWorker *)arg;
+  unsigned b;
+  while ((b = atomic_fetch_add(&w->tuner->nextBlock, 1)) <
+         w->tuner->blockCount)
+    processBlock(w, b);
+  return NULL;
+}
+
+// One pass over the data with `threads` workers. Returns the mean loss and,
+// when asked, the mean gradient; both are reduced in block order.
+static double runPass(struct Tuner *t, struct TunerWorker *workers,
+                      unsigned threads, double *gradient) {
+  pthread_t ids[threads];
+  t->withGradient = gradient != NULL;
+  atomic_store(&t->nextBlock, 0);
+  // Workers share the block counter, so the ones that start cover every
+  // block; with none started this thread does the pass itself
+  unsigned started = 0;
+  while (started < threads) {
+    void *arg = &workers[started];
+    if (pthread_create(&ids[started], NULL, tunerWorker, arg) != 0)
+      break;
+    started++;
+  }
+  if (started < threads)
+    fprintf(stderr, "Started %u of %u threads\n", started, threads);
+  if (started == 0)
+    tunerWorker(&workers[0]);
+  for (unsigned i = 0; i < started; i++)
+    pthread_join(ids[i], NULL);
+
+  double loss = 0.0;
+  for (unsigned b = 0; b < t->blockCount; b++)
+    loss += t->blockLoss[b];
+
+  if (gradient != NULL) {
+    memset(gradient, 0, PARAM_COUNT * sizeof(double));
+    for (unsigned b = 0; b < t->blockCount; b++) {
+      const double *block = &t->blockGradient[(size_t)b * PARAM_COUNT];
+      for (int j = 0; j < PARAM_COUNT; j++)
+        gradient[j] += block[j];
+    }
+    for (int j = 0; j < PARAM_COUNT; j++)
+      gradient[j] /= t->positionCount;
+  }
+  return loss / t->positionCount;
+}
+
+// Golden-section search for the sigmoid slope that best fits the starting
+// parameters; the slope then stays fixed while the parameters move
+static double fitK(struct Tuner *t, struct TunerWorker *workers) {
+  const double ratio = (sqrt(5.0) - 1.0) / 2.0;
+  double lo = 0.0001, hi = 0.05;
+  double a = hi - ratio * (hi - lo), b = lo + ratio * (hi - lo);
+  t->k = a;
+  double lossA = runPass(t, workers, t->threads, NULL);
+  t->k = b;
+  double lossB = runPass(t, workers, t->threads, NULL);
+
+  // Each step keeps one interior point, so it costs a single pass
+  for (int i = 0; i < 30; i++) {
+    if (lossA < lossB) {
+      hi = b;
+      b = a;
+      lossB = lossA;
+      a = hi - ratio * (hi - lo);
+      t->k = a;
+      lossA = runPass(t, workers, t->threads, NULL);
+    } else {
+      lo = a;
+      a = b;
+      lossA = lossB;
+      b = lo + ratio * (hi - lo);
+      t->k = b;
+      lossB = runPass(t, workers, t->threads, NULL);
+    }
+  }
+  return (lo + hi) / 2.0;
+}
+
+static void paramsFromEval(const struct EvalParams *eval, double *params) {
+  for (int type = 0; type < 6; type++) {
+    params[type] = eval->material[type];
+    for (int i = 0; i < 64; i++)
+      params[PST_PARAM(type, i)] = eval->pst[type][i];
+  }
+}
+
+static void evalFromParams(const double *params, struct EvalParams *eval) {
+  for (int type = 0; type < 6; type++) {
+    eval->material[type] = (int)lround(params[type]);
+    for (int i = 0; i < 64; i++)
+      eval->pst[type][i] = (int)lround(params[PST_PARAM(type, i)]);
+  }
+}
+
+static bool mapData(struct Tuner *t, char **paths, int count) {
+  size_t blockCapacity = 0;
+
+  for (int f = 0; f < count; f++) {
+    int fd = open(paths[f], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 ||
+        st.st_size % sizeof(struct PackedPosition) != 0) {
+      fprintf(stderr, "'%s' is not a packed position file\n", paths[f]);
+      if (fd >= 0)
+        close(fd);
+      return false;
+    }
+    size_t positions = st.st_size / sizeof(struct PackedPosition);
+    if (positions == 0) {
+      close(fd);
+      continue;
+    }
+
+    const struct PackedPosition *data = (const struct PackedPosition *)mmap(
+        NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      fprintf(stderr, "Failed to map '%s'\n", paths[f]);
+      return false;
+    }
+    // Features are read by walking the occupancy bits, which must not run
+    // past the 32 piece nibbles
+    for (size_t i = 0; i < positions; i++) {
+      if (__builtin_popcountll(data[i].occupancy) > 32) {
+        fprintf(stderr, "Corrupt record %zu in '%s'\n", i, paths[f]);
+        return false;
+      }
+    }
+
+    for (size_t first = 0; first < positions; first += BLOCK_POSITIONS) {
+      if (t->blockCount == blockCapacity) {
+        blockCapacity = blockCapacity ? blockCapacity * 2 : 1024;
+        t->blocks = (struct Block *)realloc(
+            t->blocks, blockCapacity * sizeof(struct Block));
+        if (t->blocks == NULL)
+          return false;
+      }
+      size_t left = positions - first;
+      t->blocks[t->blockCount++] = (struct Block){
+          data + first, left < BLOCK_POSITIONS ? left : BLOCK_POSITIONS};
+    }
+    t->positionCount += positions;
+  }
+  return t->positionCount > 0;
+}
+
+// Gradient passes at 1, 2, 4... threads: wall time, speed-up over one
+// thread, and whether the result matches the single-threaded one exactly
+static void checkScaling(struct Tuner *t, struct TunerWorker *workers) {
+  double reference[PARAM_COUNT], gradient[PARAM_COUNT];
+  double referenceLoss = 0.0, referenceSeconds = 0.0;
+
+  // Powers of two below the configured count, then the count itself
+  unsigned counts[32], countCount = 0;
+  for (unsigned threads = 1; threads < t->threads; threads *= 2)
+    counts[countCount++] = threads;
+  counts[countCount++] = t->threads;
+
+  for (unsigned i = 0; i < countCount; i++) {
+    unsigned threads = counts[i];
+    double start = GetMonotonicTimeNs() / 1e9;
+    double loss = runPass(t, workers, threads, gradient);
+    double seconds = GetMonotonicTimeNs() / 1e9 - start;
+    if (i == 0) {
+      memcpy(reference, gradient, sizeof(reference));
+      referenceLoss = loss;
+      referenceSeconds = seconds;
+    }
+
+    bool identical = loss == referenceLoss &&
+                     memcmp(gradient, reference, sizeof(reference)) == 0;
+    printf("%3u threads: %.3f s, %.0f positions/s, speed-up %.2f, %s\n",
+           threads, seconds, t->positionCount / seconds,
+           referenceSeconds / seconds,
+           identical ? "identical" : "DIFFERENT from 1 thread");
+  }
+}
+
+int main(int argc, char **argv) {
+  static struct Tuner t;
+  unsigned epochs = 300;
+  double rate = 1.0;
+  const char *initPath = NULL, *outputPath = "tuned_params.txt";
+  bool scaling = false;
+  t.threads = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+
+  int first = 1;
+  while (first < argc && strncmp(argv[first], "--", 2) == 0) {
+    const char *option = argv[first];
+    const char *value = first + 1 < argc ? argv[first + 1] : "";
+    first += 2;
+    if (strcmp(option, "--threads") == 0)
+      t.threads = (unsigned)atoi(value);
+    else if (strcmp(option, "--epochs") == 0)
+      epochs = (unsigned)atoi(value);
+    else if (strcmp(option, "--rate") == 0)
+      rate = atof(value);
+    else if (strcmp(option, "--k") == 0)
+      t.k = atof(value);
+    else if (strcmp(option, "--init") == 0)
+      initPath = value;
+    else if (strcmp(option, "--output") == 0)
+      outputPath = value;
+    else if (strcmp(option, "--scaling") == 0) {
+      scaling = true;
+      first--;
+    } else {
+      fprintf(stderr, "Unknown option '%s'\n", option);
+      return 1;
+    }
+  }
+  if (first >= argc || argc - first > MAX_DATA_FILES) {
+    fprintf(stderr,
+            "Usage: %s [--threads N] [--epochs N] [--rate R] [--k K] "
+            "[--init params] [--output params] [--scaling] data...\n",
+            argv[0]);
+    return 1;
+  }
+  if (t.threads == 0)
+    t.threads = 1;
+
+  SetTraceLogLevel(LOG_WARNING);
+  struct EvalParams eval = DefaultEvalParams;
+  if ((initPath != NULL && !LoadEvalParams(&eval, initPath)) ||
+      !mapData(&t, argv + first, argc - first))
+    return 1;
+  paramsFromEval(&eval, t.params);
+
+  t.blockLoss = (double *)malloc(t.blockCount * sizeof(double));
+  t.blockGradient =
+      (double *)malloc((size_t)t.blockCount * PARAM_COUNT * sizeof(double));
+  struct TunerWorker *workers =
+      (struct TunerWorker *)malloc(t.threads * sizeof(struct TunerWorker));
+  if (t.blockLoss == NULL || t.blockGradient == NULL || workers == NULL) {
+    fprintf(stderr, "Failed to allocate tuner buffers\n");
+    return 1;
+  }
+  for (unsigned i = 0; i < t.threads; i++)
+    workers[i].tuner = &t;
+
+  printf("%zu positions in %u blocks, %u threads\n", t.positionCount,
+         t.blockCount, t.threads);
+  if (t.k <= 0.0)
+    t.k = fitK(&t, workers);
+  printf("k = %.6f, initial loss %.6f\n", t.k,
+         runPass(&t, workers, t.threads, NULL));
+
+  if (scaling) {
+    checkScaling(&t, workers);
+    return 0;
+  }
+
+  double gradient[PARAM_COUNT], m[PARAM_COUNT] = {0}, v[PARAM_COUNT] = {0};
+  double start = GetMonotonicTimeNs() / 1e9;
+  for (unsigned epoch = 1; epoch <= epochs; epoch++) {
+    double loss = runPass(&t, workers, t.threads, gradient);
+
+    // The king's material is fixed: every position has one per side, so
+    // its gradient is zero and the value only anchors the scale
+    for (int j = 0; j < PARAM_COUNT; j++) {
+      m[j] = ADAM_BETA1 * m[j] + (1.0 - ADAM_BETA1) * gradient[j];
+      v[j] = ADAM_BETA2 * v[j] + (1.0 - ADAM_BETA2) * gradient[j] * gradient[j];
+      double mHat = m[j] / (1.0 - pow(ADAM_BETA1, epoch));
+      double vHat = v[j] / (1.0 - pow(ADAM_BETA2, epoch));
+      t.params[j] -= rate * mHat / (sqrt(vHat) + ADAM_EPSILON);
+    }
+
+    if (epoch % 10 == 0 || epoch == epochs) {
+      double elapsed = GetMonotonicTimeNs() / 1e9 - start;
+      printf("epoch %4u  loss %.6f  %.2f s/epoch  %.0f positions/s\n", epoch,
+             loss, elapsed / epoch, t.positionCount * epoch / elapsed);
+      fflush(stdout);
+    }
+  }
+
+  evalFromParams(t.params, &eval);
+  printf("final loss %.6f\n", runPass(&t, workers, t.threads, NULL));
+  if (!SaveEvalParams(&eval, outputPath))
+    return 1;
+  printf("parameters written to '%s'\n", outputPath);
+
+  free(workers);
+  free(t.blockLoss);
+  free(t.blockGradient);
+  free(t.blocks);
+  return 0;
+}
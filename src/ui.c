@@ -0,0 +1,123 @@
+#include "ui.h"
+
+// update() only sees the game through these globals and the InputFrame it
+// is handed, so the same code runs in the window and in headless replay
+struct Piece *selected = NULL;
+struct Game *game = NULL;
+// Non-NULL while analysis mode is on
+struct Analysis *analysis = NULL;
+// Opening database mapped at startup, NULL when none was given
+struct Explorer *explorer = NULL;
+bool showExplorer = false;
+// raylib has no getter for the trace level, so the level the program chose
+// is kept here for toggleAnalysis to restore
+static int traceLogLevel = LOG_INFO;
+
+void SetAppTraceLogLevel(int level) {
+  traceLogLevel = level;
+  SetTraceLogLevel(level);
+}
+
+Vector2 GetSquareOverlabByTheCursor(const struct InputFrame *input) {
+  float mouseX = input->mouseX;
+  float mouseY = input->mouseY;
+
+  Vector2 pos = (Vector2){
+      .x = (int)(mouseX / SQUARE_SIZE),
+      .y = (int)(mouseY / SQUARE_SIZE),
+  };
+
+  TraceLog(LOG_DEBUG,
+           "Raw Mouse position: (%d, %d) - Square position: (%d, %d)",
+           (int)mouseX, (int)mouseY, (int)pos.x, (int)pos.y);
+  return pos;
+}
+
+float clamp(float value, float min, float max) {
+  const float t = value < min ? min : value;
+  return t > max ? max : t;
+}
+
+void toggleAnalysis() {
+  if (analysis != NULL) {
+    TraceLog(LOG_INFO, "Analysis mode off");
+    DeleteAnalysis(analysis);
+    analysis = NULL;
+    SetTraceLogLevel(traceLogLevel);
+    return;
+  }
+
+  // The search thread calls GetPossibleMoves millions of times a second, and
+  // debug tracing from it would flood the log and starve the search
+  if (traceLogLevel < LOG_INFO)
+    SetTraceLogLevel(LOG_INFO);
+  TraceLog(LOG_INFO, "Analysis mode on");
+  analysis = NewAnalysis(ANALYSIS_LINES);
+  StartAnalysis(analysis, game);
+}
+
+void update(const struct InputFrame *input) {
+  for (unsigned i = 0; i < input->keyCount; i++) {
+    if (input->keys[i] == KEY_A)
+      toggleAnalysis();
+    if (input->keys[i] == KEY_E && explorer != NULL)
+      showExplorer = !showExplorer;
+  }
+
+  if (input->buttons & INPUT_LEFT_PRESSED) {
+    TraceLog(LOG_DEBUG, "Left mouse button pressed");
+    Vector2 square = GetSquareOverlabByTheCursor(input);
+    selected = GetPieceInXYPosition(game, square.x, square.y);
+    if (selected != NULL) {
+      if (selected->player == GetCurrentPlayer(game)) {
+        selected->pos = (Vector2){input->mouseX, input->mouseY};
+        TraceLog(LOG_DEBUG, "piece on square %d-%d was selected",
+                 (int)selected->square.x, (int)selected->square.y);
+      } else {
+        TraceLog(LOG_DEBUG, "Can't move other player's piece");
+        selected = NULL;
+      }
+    } else {
+      TraceLog(LOG_DEBUG, "No piece on the square %d-%d", (int)square.x,
+               (int)square.y);
+    }
+  }
+  if (input->buttons & INPUT_LEFT_RELEASED) {
+    TraceLog(LOG_DEBUG, "Left mouse button released");
+    bool couldMove = false;
+    if (selected != NULL) {
+      Vector2 newSquare = GetSquareOverlabByTheCursor(input);
+      TraceLog(LOG_DEBUG, "next square %f-%f", newSquare.x, newSquare.y);
+
+      if (MovePiece(game, &selected->square, &newSquare)) {
+        TraceLog(LOG_DEBUG, "piece was released at %f-%f", selected->square.x,
+                 selected->square.y);
+        NextPlayer(game);
+        StartAnalysis(analysis, game);
+        couldMove = true;
+      } else {
+        TraceLog(LOG_DEBUG, "Can't move piece");
+      }
+      if (!couldMove) {
+        TraceLog(LOG_DEBUG, "piece was released at it origial square %f-%f",
+                 selected->square.x, selected->square.y);
+
+        selected->pos.x = selected->square.x * SQUARE_SIZE;
+        selected->pos.y = selected->square.y * SQUARE_SIZE;
+      }
+      selected = NULL;
+    }
+  }
+
+  if (input->buttons & INPUT_LEFT_DOWN) {
+    if (selected != NULL) {
+      Vector2 mousePos = {input->mouseX, input->mouseY};
+      mousePos.x =
+          clamp(mousePos.x, 0, WINDOW_WIDTH) - (float)PIECE_IMG_SIZE / 2;
+      mousePos.y =
+          clamp(mousePos.y, 0, WINDOW_WIDTH) - (float)PIECE_IMG_SIZE / 2;
+
+      selected->pos = mousePos;
+    }
+  }
+}
@@ -0,0 +1,26 @@
+#ifndef UI_H
+#define UI_H
+
+#include "analysis.h"
+#include "explorer.h"
+#include "game.h"
+#include "input.h"
+
+#define WINDOW_WIDTH 640
+#define WINDOW_HEIGHT 640
+#define ANALYSIS_LINES 3
+#define EXPLORER_PANEL_MOVES 6
+
+extern struct Piece *selected;
+extern struct Game *game;
+extern struct Analysis *analysis;
+extern struct Explorer *explorer;
+extern bool showExplorer;
+
+// Sets the trace level and remembers it, so analysis mode can quiet the log
+// while it runs and put it back afterwards
+void SetAppTraceLogLevel(int level);
+Vector2 GetSquareOverlabByTheCursor(const struct InputFrame *input);
+void update(const struct InputFrame *input);
+
+#endif // UI_H